@@ -8,15 +8,41 @@
 #define BUILD_FOLDER "bin/"
 #define OBJ_FOLDER "obj/"
 #define SRC_FOLDER "src/"
+#define PGO_FOLDER OBJ_FOLDER"pgo/"
+#define BENCH_FOLDER OBJ_FOLDER"bench/"
 
-#define FLAG_ALL  "all"
+#define FLAG_ALL     "all"
+#define FLAG_DEBUG   "debug"
+#define FLAG_RELEASE "release"
+#define FLAG_PGO     "pgo"
+#define FLAG_BENCH   "bench"
+
+// key=value arguments
+#define VALUE_CXX    "cxx="
+#define VALUE_MARCH  "march="
+#define VALUE_CORPUS "corpus="
 
 #define MAX(a, b) (a) > (b) ? (a) : (b)
 #define MIN(a, b) (a) < (b) ? (a) : (b)
 #define HAS_FLAG(__flag) check_for_pack_flag(__flag, argc, argv)
+#define GET_VALUE(__key, __default) get_pack_value(__key, __default, argc, argv)
+
+typedef enum {
+    PROFILE_DEBUG,
+    PROFILE_RELEASE,
+    PROFILE_PGO_GENERATE,
+    PROFILE_PGO_USE,
+} Profile;
+
+typedef struct {
+    Profile     profile;
+    const char *cxx;
+    const char *march;
+    const char *corpus;
+} Build_Config;
 
 int check_for_pack_flag(char *flag, int argc, char **argv) {
-    for (int i = 1; i < argc; i++) { 
+    for (int i = 1; i < argc; i++) {
         size_t a = strlen(argv[i]);
         size_t b = strlen(flag);
         if (a != b) continue;
@@ -26,19 +52,45 @@ int check_for_pack_flag(char *flag, int argc, char **argv) {
     return 0;
 }
 
-int build_chiff(void) {
+const char *get_pack_value(char *key, const char *value, int argc, char **argv) {
+    size_t b = strlen(key);
+
+    for (int i = 1; i < argc; i++) {
+        size_t a = strlen(argv[i]);
+        if (a < b) continue;
+        if (memcmp(argv[i], key, b) == 0) return argv[i] + b;
+    }
+
+    return value;
+}
+
+#ifdef _WIN32
+int build_target(Build_Config *config, const char *source, const char *output) {
     Nob_Cmd cmd = { 0 };
 
     nob_cmd_append(&cmd, "clang-cl", "/std:c++14", "/W3", "/utf-8");
 
-    nob_cmd_append(&cmd, 
+    nob_cmd_append(&cmd,
             "/D_CRT_SECURE_NO_WARNINGS",
-            "/D_WINSOCK_DEPRECATED_NO_WARNINGS",
-            "/DDEBUG",
+            "/D_WINSOCK_DEPRECATED_NO_WARNINGS");
 
-            "-FC", "/Zi", "-EHsc", "-mavx2", "-maes", "-mpclmul",
-            "-o", BUILD_FOLDER"chiff",
-            SRC_FOLDER"main.cpp",
+    switch (config->profile) {
+        case PROFILE_DEBUG:
+            nob_cmd_append(&cmd, "/DDEBUG");
+            break;
+        case PROFILE_RELEASE:
+            nob_cmd_append(&cmd, "/O2", "-flto");
+            break;
+        case PROFILE_PGO_GENERATE:
+        case PROFILE_PGO_USE:
+            nob_log(NOB_ERROR, "pgo builds are only set up for linux.");
+            return 0;
+    }
+
+    nob_cmd_append(&cmd,
+            "-FC", "/Zi", "-EHsc",
+            "-o", output,
+            source,
 
             "-Ic:.\\deps",
             "-Ic:.\\external",
@@ -47,6 +99,188 @@ int build_chiff(void) {
     if (!nob_cmd_run_sync_and_reset(&cmd)) return 0;
     return 1;
 }
+#else
+int build_target(Build_Config *config, const char *source, const char *output) {
+    Nob_Cmd cmd = { 0 };
+
+    int clang = strstr(config->cxx, "clang") != NULL;
+
+    nob_cmd_append(&cmd, config->cxx, "-std=c++14", "-Wall", "-Wno-ignored-attributes", "-Wno-unused-function");
+
+    switch (config->profile) {
+        case PROFILE_DEBUG:
+            nob_cmd_append(&cmd, "-DDEBUG", "-O0", "-g");
+            break;
+        case PROFILE_RELEASE:
+        case PROFILE_PGO_GENERATE:
+        case PROFILE_PGO_USE:
+            nob_cmd_append(&cmd, "-O3", "-g", "-flto", nob_temp_sprintf("-march=%s", config->march));
+            break;
+    }
+
+    if (config->profile == PROFILE_PGO_GENERATE) {
+        if (clang) {
+            nob_cmd_append(&cmd, "-fprofile-instr-generate");
+        } else {
+            nob_cmd_append(&cmd, "-fprofile-generate="PGO_FOLDER, "-fprofile-update=atomic");
+        }
+    }
+
+    if (config->profile == PROFILE_PGO_USE) {
+        if (clang) {
+            nob_cmd_append(&cmd, "-fprofile-instr-use="PGO_FOLDER"chiff.profdata");
+        } else {
+            nob_cmd_append(&cmd, "-fprofile-use="PGO_FOLDER, "-fprofile-correction", "-Wno-missing-profile");
+        }
+    }
+
+    nob_cmd_append(&cmd,
+            "-o", output,
+            source,
+
+            "-Ideps",
+            "-lpthread");
+
+    if (!nob_cmd_run_sync_and_reset(&cmd)) return 0;
+    return 1;
+}
+#endif
+
+int build_chiff(Build_Config *config) {
+    return build_target(config, SRC_FOLDER"main.cpp", BUILD_FOLDER"chiff");
+}
+
+// the benchmark is always optimized, timing a debug build tells nothing
+int build_bench(Build_Config *config) {
+    Build_Config bench = *config;
+    if (bench.profile == PROFILE_DEBUG) bench.profile = PROFILE_RELEASE;
+
+    return build_target(&bench, SRC_FOLDER"bench.cpp", BUILD_FOLDER"chiff_bench");
+}
+
+#ifndef _WIN32
+// runs with stdout going to /dev/null, redirect closes the fd after the run
+int run_silent(Nob_Cmd *cmd) {
+    Nob_Fd null = nob_fd_open_for_write("/dev/null");
+    if (null == NOB_INVALID_FD) return 0;
+
+    if (!nob_cmd_run_sync_redirect_and_reset(cmd, (Nob_Cmd_Redirect) { .fdout = &null })) return 0;
+    return 1;
+}
+
+int compare_paths(const void *a, const void *b) {
+    return strcmp(*(const char **)a, *(const char **)b);
+}
+
+// diffs the corpus files in sorted pairs (the benchmark writes every case as <name>_a and <name>_b)
+// and every file against itself, in all the modes, so the profile sees scanning, hashing,
+// every engine and both printers
+int run_training(Build_Config *config) {
+    Nob_File_Paths files = { 0 };
+    if (!nob_read_entire_dir(config->corpus, &files)) return 0;
+
+    Nob_File_Paths paths = { 0 };
+
+    for (size_t i = 0; i < files.count; i++) {
+        if (files.items[i][0] == '.') continue;
+
+        const char *path = nob_temp_sprintf("%s/%s", config->corpus, files.items[i]);
+        if (nob_get_file_type(path) != NOB_FILE_REGULAR) continue;
+
+        nob_da_append(&paths, path);
+    }
+
+    if (paths.count == 0) {
+        nob_log(NOB_ERROR, "training corpus %s has no files.", config->corpus);
+        return 0;
+    }
+
+    const char *modes[][2] = {
+        { "--myers",     NULL },
+        { "--myers",     "-u" },
+        { "--patience",  "-u" },
+        { "--histogram", "-u" },
+    };
+
+    Nob_Cmd cmd = { 0 };
+
+    qsort(paths.items, paths.count, sizeof(*paths.items), compare_paths);
+
+    for (size_t i = 0; i < paths.count; i++) {
+        const char *origin = paths.items[i];
+
+        if (i % 2 == 0 && i + 1 < paths.count) {
+            const char *compare = paths.items[i + 1];
+
+            for (size_t mode = 0; mode < NOB_ARRAY_LEN(modes); mode++) {
+                nob_cmd_append(&cmd, BUILD_FOLDER"chiff", modes[mode][0]);
+                if (modes[mode][1]) nob_cmd_append(&cmd, modes[mode][1]);
+                nob_cmd_append(&cmd, origin, compare);
+
+                if (!run_silent(&cmd)) return 0;
+            }
+        }
+
+        nob_cmd_append(&cmd, BUILD_FOLDER"chiff", origin, origin);
+        if (!run_silent(&cmd)) return 0;
+    }
+
+    return 1;
+}
+
+int merge_profile(Build_Config *config) {
+    if (!strstr(config->cxx, "clang")) return 1;
+
+    Nob_File_Paths files = { 0 };
+    if (!nob_read_entire_dir(PGO_FOLDER, &files)) return 0;
+
+    Nob_Cmd cmd = { 0 };
+    nob_cmd_append(&cmd, "llvm-profdata", "merge", "-output="PGO_FOLDER"chiff.profdata");
+
+    for (size_t i = 0; i < files.count; i++) {
+        if (!nob_sv_end_with(nob_sv_from_cstr(files.items[i]), ".profraw")) continue;
+        nob_cmd_append(&cmd, nob_temp_sprintf(PGO_FOLDER"%s", files.items[i]));
+    }
+
+    if (!nob_cmd_run_sync_and_reset(&cmd)) return 0;
+    return 1;
+}
+
+// writes the benchmark's synthetic corpus into BENCH_FOLDER
+int generate_corpus(Build_Config *config) {
+    if (!build_bench(config)) return 0;
+
+    Nob_Cmd cmd = { 0 };
+    nob_cmd_append(&cmd, BUILD_FOLDER"chiff_bench", "generate", BENCH_FOLDER);
+
+    if (!nob_cmd_run_sync_and_reset(&cmd)) return 0;
+    return 1;
+}
+
+// instrumented build, training runs, then the final build with the profile
+int build_chiff_pgo(Build_Config *config) {
+    if (!nob_mkdir_if_not_exists(OBJ_FOLDER)) return 0;
+    if (!nob_mkdir_if_not_exists(PGO_FOLDER)) return 0;
+
+    // without corpus= the profile is trained on the benchmark corpus
+    if (config->corpus == NULL) {
+        if (!generate_corpus(config)) return 0;
+        config->corpus = BENCH_FOLDER;
+    }
+
+    // clang writes raw profiles wherever this points
+    setenv("LLVM_PROFILE_FILE", PGO_FOLDER"chiff-%p.profraw", 1);
+
+    config->profile = PROFILE_PGO_GENERATE;
+    if (!build_chiff(config)) return 0;
+    if (!run_training(config)) return 0;
+    if (!merge_profile(config)) return 0;
+
+    config->profile = PROFILE_PGO_USE;
+    if (!build_chiff(config)) return 0;
+    return 1;
+}
+#endif
 
 
 int main(int argc, char **argv) {
@@ -55,12 +289,35 @@ int main(int argc, char **argv) {
 
     if (!nob_mkdir_if_not_exists(BUILD_FOLDER)) return 1;
 
+    Build_Config config = { 0 };
+    config.profile = PROFILE_DEBUG;
+    config.cxx     = GET_VALUE(VALUE_CXX, "clang++");
+    config.march   = GET_VALUE(VALUE_MARCH, "x86-64");
+    config.corpus  = GET_VALUE(VALUE_CORPUS, NULL);
+
+    if (HAS_FLAG(FLAG_RELEASE)) config.profile = PROFILE_RELEASE;
+
+    if (HAS_FLAG(FLAG_PGO)) {
+#ifdef _WIN32
+        nob_log(NOB_ERROR, "pgo builds are only set up for linux.");
+        return 1;
+#else
+        if (!build_chiff_pgo(&config)) return 1;
+        return 0;
+#endif
+    }
+
+    if (HAS_FLAG(FLAG_BENCH)) {
+        if (!build_bench(&config)) return 1;
+        return 0;
+    }
+
     if (HAS_FLAG(FLAG_ALL)) {
-        if (!build_chiff()) return 1;
+        if (!build_chiff(&config)) return 1;
+        if (!build_bench(&config)) return 1;
         return 0;
     }
 
-    if (!build_chiff()) return 1;
+    if (!build_chiff(&config)) return 1;
     return 0;
 }
-
@@ -1,5 +1,6 @@
 enum Allocator_Message {
     ALLOCATOR_ALLOCATE,
+    ALLOCATOR_ALLOCATE_UNINIT, // contents are undefined, for memory that gets overwritten anyway
     ALLOCATOR_REALLOCATE,
     ALLOCATOR_DEALLOCATE,
     ALLOCATOR_DELETE
@@ -18,6 +19,7 @@ struct Allocator {
 };
 
 #define mem_alloc(alloc, size)        (alloc).proc(NULL, size, ALLOCATOR_ALLOCATE,   (alloc).data)
+#define mem_alloc_uninit(alloc, size) (alloc).proc(NULL, size, ALLOCATOR_ALLOCATE_UNINIT, (alloc).data)
 #define mem_realloc(alloc, ptr, size) (alloc).proc(ptr,  size, ALLOCATOR_REALLOCATE, (alloc).data)
 #define mem_free(alloc, ptr)          (alloc).proc(ptr,  0,    ALLOCATOR_DEALLOCATE, (alloc).data)
 #define mem_delete(alloc)             (alloc).proc(NULL, 0,    ALLOCATOR_DELETE,     (alloc).data)
@@ -29,6 +31,8 @@ ALLOCATOR_PROC(stdlib_allocator_proc) {
     switch (message) {
         case ALLOCATOR_ALLOCATE:
             return calloc(1, size);
+        case ALLOCATOR_ALLOCATE_UNINIT:
+            return malloc(size);
         case ALLOCATOR_REALLOCATE:
             return realloc((u8*)p, size);
         case ALLOCATOR_DEALLOCATE:
@@ -48,34 +52,152 @@ Allocator get_stdlib_allocator(void) {
 
 /// Temp Allocator
 
-#define TEMP_SIZE MB(50)
+//
+// reserves a big range of address space once and commits pages as the index moves
+// into them. temp_reset decommits everything above TEMP_KEEP_COMMITTED, and
+// temp_mark / temp_restore rewind to a save point so loops can reuse the same memory.
 
-struct {
+#define TEMP_RESERVE        GB(64)
+#define TEMP_COMMIT_STEP    MB(1)
+#define TEMP_KEEP_COMMITTED MB(64)
+
+// every thread gets its own reservation
+static thread_local struct {
     b32 initialized;
     u64 index;
-    u64 size; 
-    u8 data[TEMP_SIZE];
-} __temp_alloc = { false, 0, TEMP_SIZE };
+    u64 last; // start of the latest allocation, it can grow in place
+    u64 committed;
+    u64 size;
+    u8 *data;
+} __temp_alloc = { false, 0, 0, 0, TEMP_RESERVE, NULL };
+
+static void *vm_reserve(u64 size) {
+#ifdef _WIN32
+    return VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    void *data = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return data == MAP_FAILED ? NULL : data;
+#endif
+}
+
+static b32 vm_commit(void *data, u64 size) {
+#ifdef _WIN32
+    return VirtualAlloc(data, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+    return mprotect(data, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+static void vm_release(void *data, u64 size) {
+#ifdef _WIN32
+    UNUSED(size);
+    VirtualFree(data, 0, MEM_RELEASE);
+#else
+    munmap(data, size);
+#endif
+}
+
+static void vm_decommit(void *data, u64 size) {
+#ifdef _WIN32
+    VirtualFree(data, size, MEM_DECOMMIT);
+#else
+    madvise(data, size, MADV_DONTNEED);
+    mprotect(data, size, PROT_NONE);
+#endif
+}
 
 void temp_reset(void) {
     __temp_alloc.index = 0;
+    __temp_alloc.last  = 0;
+
+    if (__temp_alloc.committed > TEMP_KEEP_COMMITTED) {
+        vm_decommit(__temp_alloc.data + TEMP_KEEP_COMMITTED, __temp_alloc.committed - TEMP_KEEP_COMMITTED);
+        __temp_alloc.committed = TEMP_KEEP_COMMITTED;
+    }
+}
+
+// gives the reservation back, threads call this before they exit
+void temp_release(void) {
+    if (!__temp_alloc.data) return;
+
+    vm_release(__temp_alloc.data, __temp_alloc.size);
+
+    __temp_alloc.initialized = false;
+    __temp_alloc.index       = 0;
+    __temp_alloc.last        = 0;
+    __temp_alloc.committed   = 0;
+    __temp_alloc.data        = NULL;
+}
+
+u64 temp_mark(void) {
+    return __temp_alloc.index;
+}
+
+void temp_restore(u64 mark) {
+    assert(mark <= __temp_alloc.index);
+    __temp_alloc.index = mark;
+    __temp_alloc.last  = mark;
 }
 
-void *temp_allocate(u64 size) {
-    if ((__temp_alloc.index + size) > __temp_alloc.size) {
-        fprintf(stderr, "Temp allocator wrapped!");
-        temp_reset();
+void *temp_allocate(u64 size, b32 zero = true) {
+    if (!__temp_alloc.data) {
+        __temp_alloc.data = (u8*)vm_reserve(__temp_alloc.size);
+
+        if (!__temp_alloc.data) {
+            fprintf(stderr, "Couldn't reserve temp memory!");
+            return NULL;
+        }
     }
 
-    if ((__temp_alloc.index + size) > __temp_alloc.size) {
+    u64 start = (__temp_alloc.index + 7) & ~7ULL;
+
+    if ((start + size) > __temp_alloc.size) {
         fprintf(stderr, "Too much space requested!");
         return NULL;
     }
 
+    if ((start + size) > __temp_alloc.committed) {
+        u64 committed = (start + size + TEMP_COMMIT_STEP - 1) & ~(TEMP_COMMIT_STEP - 1);
+
+        if (!vm_commit(__temp_alloc.data + __temp_alloc.committed, committed - __temp_alloc.committed)) {
+            fprintf(stderr, "Couldn't commit temp memory, buy more ram!");
+            return NULL;
+        }
+
+        __temp_alloc.committed = committed;
+    }
 
-    void *pos = (u8*)__temp_alloc.data + __temp_alloc.index;
-    __temp_alloc.index += size;
-    mem_set((u8*)pos, 0x00, size);
+    void *pos = __temp_alloc.data + start;
+    __temp_alloc.last  = start;
+    __temp_alloc.index = start + size;
+
+    if (zero) mem_set((u8*)pos, 0x00, size);
+    return pos;
+}
+
+// the latest allocation grows in place, anything else moves to the top.
+// old size isn't known, so the move copies up to the end of used memory.
+void *temp_reallocate(void *p, u64 size) {
+    if (p == NULL) return temp_allocate(size, false);
+
+    u64 start = (u64)((u8*)p - __temp_alloc.data);
+    assert(start < __temp_alloc.index);
+
+    if (start == __temp_alloc.last) {
+        u64 index = __temp_alloc.index;
+        __temp_alloc.index = start;
+
+        void *pos = temp_allocate(size, false);
+        assert(pos == NULL || pos == p);
+
+        if (pos == NULL) __temp_alloc.index = index;
+        return pos;
+    }
+
+    u64 used = MIN(size, __temp_alloc.index - start);
+    void *pos = temp_allocate(size, false);
+
+    if (pos) mem_copy((u8*)pos, (u8*)p, used);
     return pos;
 }
 
@@ -88,7 +210,10 @@ ALLOCATOR_PROC(temp_allocator_proc) {
     switch (message) {
         case ALLOCATOR_ALLOCATE:
             return temp_allocate(size);
+        case ALLOCATOR_ALLOCATE_UNINIT:
+            return temp_allocate(size, false);
         case ALLOCATOR_REALLOCATE:
+            return temp_reallocate(p, size);
         case ALLOCATOR_DEALLOCATE:
             break;
         case ALLOCATOR_DELETE:
@@ -108,6 +233,7 @@ Allocator get_temporary_allocator(void) {
 struct Arena {
     u64 size;
     u64 occupied;
+    u64 last; // offset of the latest allocation in this block
     Arena *next;
     u8 data[];
 };
@@ -141,6 +267,7 @@ void arena_delete(Arena *arena) {
 void *arena_allocate(u64 size, Arena *arena) {
     if (size <= (arena->size - arena->occupied)) {
         u8* pos = arena->data + arena->occupied;
+        arena->last      = arena->occupied;
         arena->occupied += size;
         return (void*)pos;
     }
@@ -152,17 +279,45 @@ void *arena_allocate(u64 size, Arena *arena) {
     return arena_allocate(size, arena->next);
 }
 
+// same rules as the temp allocator: latest allocation of a block grows in place if it fits,
+// anything else is copied into a new allocation
+void *arena_reallocate(void *p, u64 size, Arena *arena) {
+    if (p == NULL) return arena_allocate(size, arena);
+
+    Arena *block = arena;
+    while (block && !((u8*)p >= block->data && (u8*)p < block->data + block->occupied)) {
+        block = block->next;
+    }
+
+    assert(block != NULL);
+    if (block == NULL) return NULL;
+
+    u64 start = (u64)((u8*)p - block->data);
+
+    if (start == block->last && size <= (block->size - start)) {
+        block->occupied = start + size;
+        return p;
+    }
+
+    u64 used = MIN(size, block->occupied - start);
+    void *pos = arena_allocate(size, arena);
+
+    if (pos) mem_copy((u8*)pos, (u8*)p, used);
+    return pos;
+}
+
 ALLOCATOR_PROC(arena_allocator_proc) {
     assert(data != NULL);
 
     Arena *arena = (Arena*)data;
     
     switch (message) {
+        // arena blocks come zeroed from calloc and are never reused
         case ALLOCATOR_ALLOCATE:
+        case ALLOCATOR_ALLOCATE_UNINIT:
             return arena_allocate(size, arena);
         case ALLOCATOR_REALLOCATE:
-            fprintf(stderr, "Arena doesn't reallocate.");
-            break;
+            return arena_reallocate(p, size, arena);
         case ALLOCATOR_DEALLOCATE:
             fprintf(stderr, "Arena doesn't free it's memory, please destroy arena itself.");
             break;
@@ -0,0 +1,363 @@
+// benchmark, built as its own binary by `build bench`
+#define CHIFF_NO_MAIN
+#include "main.cpp"
+
+/// Synthetic corpus
+//
+// every case is a pair of files, the compare file is the origin with random edits.
+// the generator is seeded per case, so the corpus is the same on every run and machine.
+
+#define BENCH_DEFAULT_DIR "obj/bench/"
+#define BENCH_DEFAULT_RUNS 3
+
+// repeated lines are drawn from a small pool, like braces and blank lines in code
+#define BENCH_REPEAT_POOL 32
+
+struct Bench_Case {
+    const char *name;
+
+    u64 lines;
+    u32 line_length;  // average, actual lengths spread from half to one and a half of it
+    f64 edit_density; // chance for every origin line to be deleted, replaced or get an insert
+    f64 repeat_ratio; // chance for a line to come from the repeat pool
+    b32 crlf;
+};
+
+static Bench_Case bench_cases[] = {
+    { "small",       2000,    40, 0.01,   0.1, false },
+    { "medium",      200000,  60, 0.001,  0.1, false },
+    { "dense_edits", 20000,   60, 0.05,   0.1, false },
+    { "long_lines",  20000,   400, 0.01,  0.1, false },
+    { "short_lines", 500000,  8,  0.001,  0.1, false },
+    { "repetitive",  100000,  30, 0.005,  0.9, false },
+    { "crlf",        100000,  60, 0.002,  0.1, true  },
+    { "large",       1000000, 60, 0.0001, 0.1, false },
+};
+
+// <dir><name>_<side>.txt, side is a or b
+static String bench_case_path(String dir, Bench_Case *bench, String side) {
+    return string_concat(dir, tformat("%s_%s.txt", STR(bench->name), side), get_temporary_allocator());
+}
+
+struct Bench_Random {
+    u64 state;
+};
+
+static u64 bench_random_next(Bench_Random *random) {
+    // splitmix64
+    u64 z = (random->state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+static u64 bench_random_range(Bench_Random *random, u64 range) {
+    return bench_random_next(random) % range;
+}
+
+static f64 bench_random_unit(Bench_Random *random) {
+    return (f64)(bench_random_next(random) >> 11) / (f64)(1ull << 53);
+}
+
+static void bench_append_line(String_Builder *builder, Bench_Random *random, Bench_Case *bench, String *pool) {
+    if (bench_random_unit(random) < bench->repeat_ratio) {
+        builder_append(builder, pool[bench_random_range(random, BENCH_REPEAT_POOL)]);
+    } else {
+        u64 length = bench->line_length / 2 + bench_random_range(random, bench->line_length + 1);
+
+        for (u64 i = 0; i < length; i++) {
+            builder_append(builder, (u8)(' ' + bench_random_range(random, 95)));
+        }
+    }
+
+    if (bench->crlf) builder_append(builder, (u8)'\r');
+    builder_append(builder, (u8)'\n');
+}
+
+// writes <dir><name>_a.txt and <dir><name>_b.txt
+b32 bench_generate_case(String dir, Bench_Case *bench, u64 seed) {
+    Allocator alloc = get_stdlib_allocator();
+
+    Bench_Random random = { seed };
+
+    // pool lines are short and mostly indentation
+    u8     pool_data[BENCH_REPEAT_POOL][32];
+    String pool[BENCH_REPEAT_POOL];
+
+    for (u64 i = 0; i < BENCH_REPEAT_POOL; i++) {
+        u64 indent = bench_random_range(&random, 4) * 4;
+        u64 text   = 1 + bench_random_range(&random, 8);
+
+        for (u64 j = 0; j < indent; j++) pool_data[i][j] = ' ';
+        for (u64 j = 0; j < text; j++)   pool_data[i][indent + j] = (u8)('!' + bench_random_range(&random, 94));
+
+        pool[i] = { indent + text, pool_data[i] };
+    }
+
+    String_Builder origin  = {};
+    String_Builder compare = {};
+
+    u64 estimate = bench->lines * (bench->line_length + 2);
+    builder_create(&origin,  alloc, estimate);
+    builder_create(&compare, alloc, estimate + estimate / 8);
+
+    for (u64 line = 0; line < bench->lines; line++) {
+        u64 start = origin.size;
+        bench_append_line(&origin, &random, bench, pool);
+
+        String text = { origin.size - start, origin.data + start };
+
+        if (bench_random_unit(&random) >= bench->edit_density) {
+            builder_append(&compare, text);
+            continue;
+        }
+
+        switch (bench_random_range(&random, 3)) {
+            case 0: // delete
+                break;
+            case 1: // replace
+                bench_append_line(&compare, &random, bench, pool);
+                break;
+            case 2: // insert a few lines after it
+                builder_append(&compare, text);
+                for (u64 i = 0; i < 1 + bench_random_range(&random, 4); i++) {
+                    bench_append_line(&compare, &random, bench, pool);
+                }
+                break;
+        }
+    }
+
+    b32 result = platform_write_file(bench_case_path(dir, bench, STR("a")), builder_to_string(&origin))
+              && platform_write_file(bench_case_path(dir, bench, STR("b")), builder_to_string(&compare));
+
+    mem_free(alloc, origin.data);
+    mem_free(alloc, compare.data);
+
+    return result;
+}
+
+b32 bench_generate(String dir) {
+    if (!platform_make_directory(dir)) return false;
+
+    for (u64 i = 0; i < sizeof(bench_cases) / sizeof(*bench_cases); i++) {
+        u64 mark = temp_mark();
+        b32 result = bench_generate_case(dir, bench_cases + i, 0x636869666600ull + i);
+        temp_restore(mark);
+
+        if (!result) return false;
+    }
+
+    return true;
+}
+
+/// Phases
+//
+// every case runs the pipeline chiff ships, phase by phase: open (mapped like chiff does),
+// fused scan and hash on the given threads, intern and diff, unified print. then the whole
+// of diff_files once more as the end to end time. the fastest of all runs is reported.
+
+struct Bench_Timing {
+    u64 best;
+};
+
+static void bench_record(Bench_Timing *timing, u64 start) {
+    u64 elapsed = platform_time_ns() - start;
+    if (timing->best == 0 || elapsed < timing->best) timing->best = elapsed;
+}
+
+static void bench_report(const char *name, const char *phase, Bench_Timing timing, u64 lines, u64 bytes) {
+    f64 seconds = (f64)(timing.best ? timing.best : 1) / 1e9;
+
+    INFLOG("%-12s %-16s %10.3f ms %10.2f Mlines/s %10.1f MB/s\n",
+            name, phase, seconds * 1e3, (f64)lines / seconds / 1e6, (f64)bytes / seconds / (f64)MB(1));
+}
+
+b32 bench_run_case(String dir, Bench_Case *bench, u32 runs, u32 threads, Diff_Algorithm *algorithms, u32 algorithm_count) {
+    char *paths[2] = {
+        tcstr(bench_case_path(dir, bench, STR("a"))),
+        tcstr(bench_case_path(dir, bench, STR("b"))),
+    };
+
+    Bench_Timing open      = {};
+    Bench_Timing scan_hash = {};
+
+    u64 lines = 0;
+    u64 bytes = 0;
+
+    const char *algorithm_names[] = { "myers", "patience", "histogram" };
+
+    Output output = {};
+    if (!output_create(&output)) return false;
+    output.discard = true;
+
+    for (u32 a = 0; a < algorithm_count; a++) {
+        Options options = {};
+        options.algorithm = algorithms[a];
+        options.threads   = threads;
+        options.unified   = true;
+        options.context   = 3;
+
+        Bench_Timing diff  = {};
+        Bench_Timing print = {};
+        Bench_Timing total = {};
+
+        for (u32 run = 0; run < runs; run++) {
+            Input_File   inputs[2] = {};
+            Hashed_Lines scans[2]  = {};
+
+            u64 start = platform_time_ns();
+            for (u32 i = 0; i < 2; i++) {
+                if (!platform_open_input(STR(paths[i]), inputs + i)) return false;
+            }
+            bench_record(&open, start);
+
+            start = platform_time_ns();
+            for (u32 i = 0; i < 2; i++) scans[i] = scan_and_hash_lines(inputs[i].data, threads);
+            bench_record(&scan_hash, start);
+
+            lines = scans[0].lines.count + scans[1].lines.count;
+            bytes = inputs[0].data.size + inputs[1].data.size;
+
+            u64 mark = temp_mark();
+            Subseq *begin = NULL;
+
+            start = platform_time_ns();
+            if (!diff_hashes(&options, &scans[0].hashes, &scans[1].hashes, get_temporary_allocator(), &begin)) return false;
+            bench_record(&diff, start);
+
+            Diff_Side origin_side  = { paths[0], inputs[0].data, scans[0].lines };
+            Diff_Side compare_side = { paths[1], inputs[1].data, scans[1].lines };
+
+            start = platform_time_ns();
+            print_unified(&output, &origin_side, &compare_side, begin, options.context);
+            output_flush(&output);
+            bench_record(&print, start);
+
+            temp_restore(mark);
+
+            for (u32 i = 0; i < 2; i++) {
+                if (scans[i].lines.data) list_delete(&scans[i].lines);
+                platform_close_input(inputs + i);
+            }
+
+            b32 different = false;
+
+            start = platform_time_ns();
+            if (!diff_files(&options, paths[0], paths[1], threads, &output, &different)) return false;
+            output_flush(&output);
+            bench_record(&total, start);
+        }
+
+        const char *name = algorithm_names[algorithms[a]];
+
+        if (a == 0) {
+            bench_report(bench->name, "open", open, lines, bytes);
+            bench_report(bench->name, "scan_hash", scan_hash, lines, bytes);
+        }
+
+        bench_report(bench->name, tcstr(tformat("diff %s", STR(name))), diff, lines, bytes);
+        bench_report(bench->name, tcstr(tformat("print %s", STR(name))), print, lines, bytes);
+        bench_report(bench->name, tcstr(tformat("total %s", STR(name))), total, lines, bytes);
+    }
+
+    output_delete(&output);
+
+    return true;
+}
+
+// every case has both of its files
+b32 bench_corpus_exists(String dir) {
+    for (u64 i = 0; i < sizeof(bench_cases) / sizeof(*bench_cases); i++) {
+        File_Info info = {};
+
+        u64 mark = temp_mark();
+        b32 exists = platform_file_info(bench_case_path(dir, bench_cases + i, STR("a")), &info)
+                  && platform_file_info(bench_case_path(dir, bench_cases + i, STR("b")), &info);
+        temp_restore(mark);
+
+        if (!exists) return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    hash_init();
+
+    String dir = STR(BENCH_DEFAULT_DIR);
+    u32 runs    = BENCH_DEFAULT_RUNS;
+    u32 threads = platform_cpu_count();
+    b32 generate_only = false;
+
+    b32 selected[3] = {};
+
+    for (int i = 1; i < argc; i++) {
+        String arg = STR(argv[i]);
+
+        if (!string_compare(arg, STR("generate"))) {
+            generate_only = true;
+        } else if (!string_compare(arg, STR("--myers"))) {
+            selected[DIFF_MYERS] = true;
+        } else if (!string_compare(arg, STR("--patience"))) {
+            selected[DIFF_PATIENCE] = true;
+        } else if (!string_compare(arg, STR("--histogram"))) {
+            selected[DIFF_HISTOGRAM] = true;
+        } else if (!string_compare(arg, STR("-r")) && i + 1 < argc) {
+            u64 value = 0;
+
+            if (!parse_number(argv[++i], &value) || value == 0 || value > 0xffffffffull) {
+                ERRLOG("runs has to be a number of at least 1: %s\n", argv[i]);
+                return 1;
+            }
+
+            runs = (u32)value;
+        } else if (!string_compare(arg, STR("-j")) && i + 1 < argc) {
+            u64 value = 0;
+
+            if (!parse_number(argv[++i], &value) || value == 0) {
+                ERRLOG("threads has to be a number of at least 1: %s\n", argv[i]);
+                return 1;
+            }
+
+            threads = (u32)MIN(value, (u64)OPTION_MAX_THREADS);
+        } else if (arg.size > 0 && arg.data[0] != '-') {
+            dir = arg;
+        } else {
+            ERRLOG("usage: %s [generate] [--myers | --patience | --histogram]... [-r runs] [-j threads] [dir]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // all of them when none is picked
+    Diff_Algorithm algorithms[3] = {};
+    u32 algorithm_count = 0;
+
+    for (u32 i = 0; i < 3; i++) {
+        if (selected[i]) algorithms[algorithm_count++] = (Diff_Algorithm)i;
+    }
+
+    if (algorithm_count == 0) {
+        for (u32 i = 0; i < 3; i++) algorithms[algorithm_count++] = (Diff_Algorithm)i;
+    }
+
+    // paths are joined as <dir><name>
+    if (dir.data[dir.size - 1] != '/' && dir.data[dir.size - 1] != '\\') {
+        dir = string_concat(dir, STR("/"), get_stdlib_allocator());
+    }
+
+    // the corpus is the same on every run, it's only written when asked for or missing
+    if (generate_only || !bench_corpus_exists(dir)) {
+        if (!bench_generate(dir)) return 2;
+    }
+
+    if (generate_only) return 0;
+
+    INFLOG("%-12s %-16s %13s %19s %15s\n", "case", "phase", "time", "lines", "bytes");
+
+    for (u64 i = 0; i < sizeof(bench_cases) / sizeof(*bench_cases); i++) {
+        if (!bench_run_case(dir, bench_cases + i, runs, threads, algorithms, algorithm_count)) return 2;
+        temp_reset();
+    }
+
+    return 0;
+}
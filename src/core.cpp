@@ -2,6 +2,23 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include <sched.h>
+#endif
+
 typedef uint8_t  u8;
 typedef uint16_t u16;
 typedef uint32_t u32;
@@ -47,8 +64,29 @@ typedef uint32_t b32;
 #else 
 #define assert(...)
 #endif
+
+// the build only assumes the x86-64 baseline, meow is compiled for aes + sse4.1
+// and only called when cpuid reports them (see hash.cpp)
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("aes,sse4.1"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("aes,sse4.1")
+#endif
+
 #include "meow_hash/meow_hash_x64_aesni.h"
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#include "cpu.cpp"
 #include "memctl.cpp"
 #include "allocators.cpp"
 #include "list.cpp"
 #include "strings.cpp"
+#include "hash.cpp"
@@ -0,0 +1,59 @@
+/// CPU features
+//
+// queried once with cpuid, kernels with wider instruction sets are built with
+// TARGET_* attributes and picked at runtime.
+
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AES  __attribute__((target("aes,sse4.1")))
+
+struct Cpu_Features {
+    b32 sse2;
+    b32 sse41;
+    b32 avx2;
+    b32 aes;
+};
+
+static void cpu_id(u32 leaf, u32 subleaf, u32 *regs) {
+    __asm__ volatile("cpuid" : "=a"(regs[0]), "=b"(regs[1]), "=c"(regs[2]), "=d"(regs[3]) : "a"(leaf), "c"(subleaf));
+}
+
+static u64 cpu_xgetbv(u32 index) {
+    u32 low, high;
+    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(index));
+    return ((u64)high << 32) | low;
+}
+
+static Cpu_Features cpu_query(void) {
+    Cpu_Features features = {};
+
+    u32 regs[4] = {};
+    cpu_id(0, 0, regs);
+    u32 max_leaf = regs[0];
+
+    if (max_leaf >= 1) {
+        cpu_id(1, 0, regs);
+
+        features.sse2  = (regs[3] >> 26) & 1;
+        features.sse41 = (regs[2] >> 19) & 1;
+        features.aes   = (regs[2] >> 25) & 1;
+
+        b32 osxsave = (regs[2] >> 27) & 1;
+        b32 avx     = (regs[2] >> 28) & 1;
+
+        // the os has to save ymm registers too
+        b32 ymm = osxsave && avx && (cpu_xgetbv(0) & 6) == 6;
+
+        if (max_leaf >= 7 && ymm) {
+            cpu_id(7, 0, regs);
+            features.avx2 = (regs[1] >> 5) & 1;
+        }
+    }
+
+    return features;
+}
+
+Cpu_Features cpu_features(void) {
+    // function statics are initialized once, even when several threads ask first
+    static Cpu_Features features = cpu_query();
+    return features;
+}
@@ -0,0 +1,816 @@
+#include <immintrin.h>
+
+struct Subseq {
+    u64 origin_index;
+    u64 compare_index;
+    Subseq *next;
+};
+
+enum Diff_Algorithm {
+    DIFF_MYERS,
+    DIFF_PATIENCE,
+    DIFF_HISTOGRAM,
+};
+
+struct Subseq_List {
+    Subseq   *first;
+    Subseq   *last;
+    Allocator alloc;
+};
+
+void subseq_push_back(Subseq_List *list, u64 origin_index, u64 compare_index) {
+    Subseq *node = (Subseq *)mem_alloc_uninit(list->alloc, sizeof(Subseq));
+    assert(node);
+
+    *node = { origin_index, compare_index, NULL };
+
+    if (list->last) {
+        list->last->next = node;
+    } else {
+        list->first = node;
+    }
+
+    list->last = node;
+}
+
+void subseq_push_front(Subseq_List *list, u64 origin_index, u64 compare_index) {
+    Subseq *node = (Subseq *)mem_alloc_uninit(list->alloc, sizeof(Subseq));
+    assert(node);
+
+    *node = { origin_index, compare_index, list->first };
+
+    if (!list->last) {
+        list->last = node;
+    }
+
+    list->first = node;
+}
+
+void subseq_append(Subseq_List *list, Subseq_List tail) {
+    if (!tail.first) return;
+
+    if (list->last) {
+        list->last->next = tail.first;
+    } else {
+        list->first = tail.first;
+    }
+
+    list->last = tail.last;
+}
+
+// the engines work on dense line ids, equal lines share an id.
+// a window is the [start, start + count) part of both id arrays that is being diffed,
+// matched pairs are reported with indices into the full arrays.
+struct Diff_Window {
+    u32 *origin;
+    u64  origin_start;
+    u64  origin_count;
+
+    u32 *compare;
+    u64  compare_start;
+    u64  compare_count;
+};
+
+/// Myers O((N+M)D) diff
+//
+// walks furthest reaching d-paths, v[k] holds furthest x on diagonal k = x - y.
+// every step saves the part of v the backtrack needs, so memory is O(D^2) on top of O(N+M).
+// gives up and returns false when the saved trace grows past myers_trace_limit.
+
+#define MYERS_TRACE_LIMIT MB(64)
+
+// lowered for diffs on a memory budget, only set before any diff runs
+static u64 myers_trace_limit = MYERS_TRACE_LIMIT;
+
+b32 myers_diff(Diff_Window window, Subseq_List *output) {
+    if (window.origin_count == 0 || window.compare_count == 0) return true;
+
+    u32 *origin  = window.origin  + window.origin_start;
+    u32 *compare = window.compare + window.compare_start;
+
+    s64 n   = (s64)window.origin_count;
+    s64 m   = (s64)window.compare_count;
+    s64 max = n + m;
+
+    Allocator alloc = get_stdlib_allocator();
+
+    // k in [-max - 1, max + 1]
+    s64 *v = (s64 *)mem_alloc_uninit(alloc, (2 * max + 3) * sizeof(s64));
+    assert(v);
+    v += max + 1;
+    v[1] = 0;
+
+    List<s64> trace = {};
+
+    s64 d = 0;
+    for (; d <= max; d++) {
+        // snapshot of v[-d - 1 .. d + 1] starts at d * d + 2 * d
+        list_write(&trace, v - d - 1, 2 * d + 3);
+
+        if (trace.count * sizeof(s64) > myers_trace_limit) {
+            list_delete(&trace);
+            mem_free(alloc, v - max - 1);
+            return false;
+        }
+
+        b32 done = false;
+
+        for (s64 k = -d; k <= d; k += 2) {
+            s64 x;
+
+            if (k == -d || (k != d && v[k - 1] < v[k + 1])) {
+                x = v[k + 1];
+            } else {
+                x = v[k - 1] + 1;
+            }
+
+            s64 y = x - k;
+
+            while (x < n && y < m && origin[x] == compare[y]) {
+                x++;
+                y++;
+            }
+
+            v[k] = x;
+
+            if (x >= n && y >= m) {
+                done = true;
+                break;
+            }
+        }
+
+        if (done) break;
+    }
+
+    Subseq_List matches = { NULL, NULL, output->alloc };
+
+    s64 x = n;
+    s64 y = m;
+
+    for (; d >= 0; d--) {
+        s64 *snapshot = trace.data + d * d + 2 * d + d + 1;
+        s64 k = x - y;
+
+        s64 prev_k;
+        if (k == -d || (k != d && snapshot[k - 1] < snapshot[k + 1])) {
+            prev_k = k + 1;
+        } else {
+            prev_k = k - 1;
+        }
+
+        s64 prev_x = snapshot[prev_k];
+        s64 prev_y = prev_x - prev_k;
+
+        while (x > prev_x && y > prev_y) {
+            x--;
+            y--;
+            subseq_push_front(&matches, window.origin_start + (u64)x, window.compare_start + (u64)y);
+        }
+
+        x = prev_x;
+        y = prev_y;
+    }
+
+    subseq_append(output, matches);
+
+    list_delete(&trace);
+    mem_free(alloc, v - max - 1);
+    return true;
+}
+
+/// Linear space Myers
+//
+// finds the middle snake of the optimal path by running d-paths from both corners
+// until they overlap, then recurses on the two halves around it. only the forward
+// and backward v arrays are kept, so memory is O(N+M) for any edit distance.
+
+struct Middle_Snake {
+    s64 x, y; // start of snake
+    s64 u, v; // end of snake
+    s64 d;    // length of the shortest edit script
+};
+
+Middle_Snake myers_middle_snake(u32 *origin, s64 n, u32 *compare, s64 m, s64 *vf, s64 *vb) {
+    s64 delta = n - m;
+    b32 odd   = delta & 1;
+
+    vf[1] = 0;
+    vb[1] = 0;
+
+    for (s64 d = 0; d <= (n + m + 1) / 2; d++) {
+        for (s64 k = -d; k <= d; k += 2) {
+            s64 x;
+
+            if (k == -d || (k != d && vf[k - 1] < vf[k + 1])) {
+                x = vf[k + 1];
+            } else {
+                x = vf[k - 1] + 1;
+            }
+
+            s64 y  = x - k;
+            s64 sx = x;
+            s64 sy = y;
+
+            while (x < n && y < m && origin[x] == compare[y]) {
+                x++;
+                y++;
+            }
+
+            vf[k] = x;
+
+            s64 c = delta - k;
+            if (odd && c >= -(d - 1) && c <= (d - 1) && vf[k] + vb[c] >= n) {
+                return { sx, sy, x, y, 2 * d - 1 };
+            }
+        }
+
+        // vb[c] is the distance from the end of origin on reversed diagonal c
+        for (s64 c = -d; c <= d; c += 2) {
+            s64 x;
+
+            if (c == -d || (c != d && vb[c - 1] < vb[c + 1])) {
+                x = vb[c + 1];
+            } else {
+                x = vb[c - 1] + 1;
+            }
+
+            s64 y  = x - c;
+            s64 sx = x;
+            s64 sy = y;
+
+            while (x < n && y < m && origin[n - x - 1] == compare[m - y - 1]) {
+                x++;
+                y++;
+            }
+
+            vb[c] = x;
+
+            s64 k = delta - c;
+            if (!odd && k >= -d && k <= d && vb[c] + vf[k] >= n) {
+                return { n - x, m - y, n - sx, m - sy, 2 * d };
+            }
+        }
+    }
+
+    assert(false);
+    return {};
+}
+
+void myers_linear_recurse(u32 *origin, s64 n, s64 origin_offset, u32 *compare, s64 m, s64 compare_offset, s64 *vf, s64 *vb, Subseq_List *output) {
+    if (n == 0 || m == 0) return;
+
+    Middle_Snake snake = myers_middle_snake(origin, n, compare, m, vf, vb);
+
+    if (snake.d > 1) {
+        myers_linear_recurse(origin, snake.x, origin_offset, compare, snake.y, compare_offset, vf, vb, output);
+
+        for (s64 i = 0; i < snake.u - snake.x; i++) {
+            subseq_push_back(output, (u64)(origin_offset + snake.x + i), (u64)(compare_offset + snake.y + i));
+        }
+
+        myers_linear_recurse(origin + snake.u, n - snake.u, origin_offset + snake.u,
+                             compare + snake.v, m - snake.v, compare_offset + snake.v, vf, vb, output);
+        return;
+    }
+
+    // at most one line inserted or deleted, the shorter side is a subsequence of the longer one
+    s64 x = 0;
+    s64 y = 0;
+
+    while (x < n && y < m) {
+        if (origin[x] == compare[y]) {
+            subseq_push_back(output, (u64)(origin_offset + x), (u64)(compare_offset + y));
+            x++;
+            y++;
+        } else if (n > m) {
+            x++;
+        } else {
+            y++;
+        }
+    }
+}
+
+void myers_diff_linear(Diff_Window window, Subseq_List *output) {
+    if (window.origin_count == 0 || window.compare_count == 0) return;
+
+    s64 max = (s64)(window.origin_count + window.compare_count);
+
+    Allocator alloc = get_stdlib_allocator();
+
+    s64 *vf = (s64 *)mem_alloc_uninit(alloc, (2 * max + 3) * sizeof(s64));
+    s64 *vb = (s64 *)mem_alloc_uninit(alloc, (2 * max + 3) * sizeof(s64));
+    assert(vf && vb);
+
+    myers_linear_recurse(window.origin  + window.origin_start,  (s64)window.origin_count,  (s64)window.origin_start,
+                         window.compare + window.compare_start, (s64)window.compare_count, (s64)window.compare_start,
+                         vf + max + 1, vb + max + 1, output);
+
+    mem_free(alloc, vf);
+    mem_free(alloc, vb);
+}
+
+// trace variant first, it is faster while the edit is small
+void myers_diff_region(Diff_Window window, Subseq_List *output) {
+    if (!myers_diff(window, output)) {
+        myers_diff_linear(window, output);
+    }
+}
+
+/// Patience and histogram diff
+//
+// both split the window on anchor lines that are rare in the window, and fall back
+// to myers on parts without anchors. patience anchors on lines that are unique in
+// both files, histogram on the lowest occurrence count it can find in origin.
+// parts are kept on an explicit stack so long files don't blow the call stack.
+
+#define HISTOGRAM_MAX_CHAIN 64
+
+struct Diff_Task {
+    Diff_Window window;
+    b32 emit; // window is a run of equal lines
+};
+
+struct Anchor_Diff {
+    u32 *origin_count;  // per id occurrences in the current window
+    u32 *compare_count;
+    u32 *position;      // per id, patience: last position in origin, histogram: head of the chain + 1
+
+    u32 *chain;         // per origin line, previous occurrence + 1
+    u32 *pair_origin;   // patience candidates and longest increasing subsequence
+    u32 *pair_compare;
+    u32 *tails;
+    u32 *previous;
+
+    List<Diff_Task> stack;
+};
+
+static void diff_push_task(Anchor_Diff *state, Diff_Window window, b32 emit) {
+    if (!emit && window.origin_count == 0 && window.compare_count == 0) return;
+
+    Diff_Task task = { window, emit };
+    list_add(&state->stack, task);
+}
+
+static Diff_Window diff_subwindow(Diff_Window window, u64 origin_start, u64 origin_stop, u64 compare_start, u64 compare_stop) {
+    window.origin_start  = origin_start;
+    window.origin_count  = origin_stop - origin_start;
+    window.compare_start = compare_start;
+    window.compare_count = compare_stop - compare_start;
+    return window;
+}
+
+// pushes parts between anchors in reverse, so they pop in file order
+static void diff_push_anchors(Anchor_Diff *state, Diff_Window window, u64 anchors) {
+    u64 origin_stop  = window.origin_start  + window.origin_count;
+    u64 compare_stop = window.compare_start + window.compare_count;
+
+    for (u64 i = anchors; i-- > 0;) {
+        u64 origin_index  = state->pair_origin[i];
+        u64 compare_index = state->pair_compare[i];
+
+        diff_push_task(state, diff_subwindow(window, origin_index + 1, origin_stop, compare_index + 1, compare_stop), false);
+        diff_push_task(state, diff_subwindow(window, origin_index, origin_index + 1, compare_index, compare_index + 1), true);
+
+        origin_stop  = origin_index;
+        compare_stop = compare_index;
+    }
+
+    diff_push_task(state, diff_subwindow(window, window.origin_start, origin_stop, window.compare_start, compare_stop), false);
+}
+
+static u64 patience_find_anchors(Anchor_Diff *state, Diff_Window window) {
+    u64 origin_stop  = window.origin_start  + window.origin_count;
+    u64 compare_stop = window.compare_start + window.compare_count;
+
+    for (u64 i = window.origin_start; i < origin_stop; i++) {
+        u32 id = window.origin[i];
+        state->origin_count[id]++;
+        state->position[id] = (u32)i;
+    }
+
+    for (u64 i = window.compare_start; i < compare_stop; i++) {
+        state->compare_count[window.compare[i]]++;
+    }
+
+    u64 candidates = 0;
+
+    for (u64 i = window.compare_start; i < compare_stop; i++) {
+        u32 id = window.compare[i];
+        if (state->origin_count[id] != 1 || state->compare_count[id] != 1) continue;
+
+        state->pair_origin[candidates]  = state->position[id];
+        state->pair_compare[candidates] = (u32)i;
+        candidates++;
+    }
+
+    for (u64 i = window.origin_start; i < origin_stop; i++) {
+        state->origin_count[window.origin[i]] = 0;
+    }
+
+    for (u64 i = window.compare_start; i < compare_stop; i++) {
+        state->compare_count[window.compare[i]] = 0;
+    }
+
+    if (candidates == 0) return 0;
+
+    // longest increasing subsequence of origin positions, patience sorting
+    u64 piles = 0;
+
+    for (u64 i = 0; i < candidates; i++) {
+        u32 value = state->pair_origin[i];
+
+        u64 low  = 0;
+        u64 high = piles;
+
+        while (low < high) {
+            u64 middle = (low + high) / 2;
+
+            if (state->pair_origin[state->tails[middle]] < value) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+
+        state->previous[i] = low > 0 ? state->tails[low - 1] : (u32)-1;
+        state->tails[low]  = (u32)i;
+
+        if (low == piles) piles++;
+    }
+
+    // walk back from the top of the last pile, writing anchors in place from the end
+    u64 anchors = piles;
+    u32 index   = state->tails[piles - 1];
+
+    for (u64 i = anchors; i-- > 0;) {
+        state->tails[i] = index;
+        index = state->previous[index];
+    }
+
+    for (u64 i = 0; i < anchors; i++) {
+        u32 pair = state->tails[i];
+        state->pair_origin[i]  = state->pair_origin[pair];
+        state->pair_compare[i] = state->pair_compare[pair];
+    }
+
+    return anchors;
+}
+
+// returns false if every line of compare occurs too often in origin
+static b32 histogram_find_anchor(Anchor_Diff *state, Diff_Window window, Diff_Window *run) {
+    u32 *origin  = window.origin;
+    u32 *compare = window.compare;
+
+    u64 origin_stop  = window.origin_start  + window.origin_count;
+    u64 compare_stop = window.compare_start + window.compare_count;
+
+    for (u64 i = window.origin_start; i < origin_stop; i++) {
+        u32 id = origin[i];
+        state->origin_count[id]++;
+        state->chain[i]     = state->position[id];
+        state->position[id] = (u32)(i + 1);
+    }
+
+    u32 best_count  = HISTOGRAM_MAX_CHAIN;
+    u64 best_length = 0;
+
+    for (u64 j = window.compare_start; j < compare_stop;) {
+        u32 count = state->origin_count[compare[j]];
+        u64 next  = j + 1;
+
+        if (count == 0 || count > best_count) {
+            j = next;
+            continue;
+        }
+
+        for (u32 at = state->position[compare[j]]; at; at = state->chain[at - 1]) {
+            u64 s = at - 1;
+            u64 t = j;
+            u64 e = s + 1;
+            u64 f = j + 1;
+
+            u32 run_count = count;
+
+            while (s > window.origin_start && t > window.compare_start && origin[s - 1] == compare[t - 1]) {
+                s--;
+                t--;
+                run_count = MIN(run_count, state->origin_count[origin[s]]);
+            }
+
+            while (e < origin_stop && f < compare_stop && origin[e] == compare[f]) {
+                run_count = MIN(run_count, state->origin_count[origin[e]]);
+                e++;
+                f++;
+            }
+
+            if (run_count < best_count || (run_count == best_count && (e - s) > best_length)) {
+                best_count  = run_count;
+                best_length = e - s;
+                *run = diff_subwindow(window, s, e, t, f);
+            }
+
+            next = MAX(next, f);
+        }
+
+        j = next;
+    }
+
+    for (u64 i = window.origin_start; i < origin_stop; i++) {
+        state->origin_count[origin[i]] = 0;
+        state->position[origin[i]]     = 0;
+    }
+
+    return best_length > 0;
+}
+
+void anchor_diff(Diff_Window window, u32 id_count, Diff_Algorithm algorithm, Subseq_List *output) {
+    Allocator alloc = get_stdlib_allocator();
+
+    u64 lines = MAX(window.origin_start + window.origin_count, window.compare_start + window.compare_count);
+
+    Anchor_Diff state = {};
+    state.origin_count  = (u32 *)mem_alloc(alloc, id_count * sizeof(u32));
+    state.compare_count = (u32 *)mem_alloc(alloc, id_count * sizeof(u32));
+    state.position      = (u32 *)mem_alloc(alloc, id_count * sizeof(u32));
+    state.chain         = (u32 *)mem_alloc_uninit(alloc, lines * sizeof(u32));
+    state.pair_origin   = (u32 *)mem_alloc_uninit(alloc, lines * sizeof(u32));
+    state.pair_compare  = (u32 *)mem_alloc_uninit(alloc, lines * sizeof(u32));
+    state.tails         = (u32 *)mem_alloc_uninit(alloc, lines * sizeof(u32));
+    state.previous      = (u32 *)mem_alloc_uninit(alloc, lines * sizeof(u32));
+
+    diff_push_task(&state, window, false);
+
+    while (state.stack.count > 0) {
+        Diff_Task task = state.stack.data[--state.stack.count];
+        Diff_Window part = task.window;
+
+        if (task.emit) {
+            for (u64 i = 0; i < part.origin_count; i++) {
+                subseq_push_back(output, part.origin_start + i, part.compare_start + i);
+            }
+            continue;
+        }
+
+        // equal head goes out now, equal tail after the middle
+        while (part.origin_count > 0 && part.compare_count > 0 && part.origin[part.origin_start] == part.compare[part.compare_start]) {
+            subseq_push_back(output, part.origin_start, part.compare_start);
+            part.origin_start++;
+            part.compare_start++;
+            part.origin_count--;
+            part.compare_count--;
+        }
+
+        u64 tail = 0;
+        while (tail < part.origin_count && tail < part.compare_count
+                && part.origin[part.origin_start + part.origin_count - tail - 1] == part.compare[part.compare_start + part.compare_count - tail - 1]) {
+            tail++;
+        }
+
+        if (tail > 0) {
+            part.origin_count  -= tail;
+            part.compare_count -= tail;
+
+            u64 origin_stop  = part.origin_start  + part.origin_count;
+            u64 compare_stop = part.compare_start + part.compare_count;
+            diff_push_task(&state, diff_subwindow(part, origin_stop, origin_stop + tail, compare_stop, compare_stop + tail), true);
+        }
+
+        if (part.origin_count == 0 || part.compare_count == 0) continue;
+
+        if (algorithm == DIFF_PATIENCE) {
+            u64 anchors = patience_find_anchors(&state, part);
+
+            if (anchors > 0) {
+                diff_push_anchors(&state, part, anchors);
+                continue;
+            }
+        } else {
+            Diff_Window run = {};
+
+            if (histogram_find_anchor(&state, part, &run)) {
+                u64 origin_stop  = part.origin_start  + part.origin_count;
+                u64 compare_stop = part.compare_start + part.compare_count;
+
+                diff_push_task(&state, diff_subwindow(part, run.origin_start + run.origin_count, origin_stop, run.compare_start + run.compare_count, compare_stop), false);
+                diff_push_task(&state, run, true);
+                diff_push_task(&state, diff_subwindow(part, part.origin_start, run.origin_start, part.compare_start, run.compare_start), false);
+                continue;
+            }
+        }
+
+        myers_diff_region(part, output);
+    }
+
+    list_delete(&state.stack);
+
+    mem_free(alloc, state.origin_count);
+    mem_free(alloc, state.compare_count);
+    mem_free(alloc, state.position);
+    mem_free(alloc, state.chain);
+    mem_free(alloc, state.pair_origin);
+    mem_free(alloc, state.pair_compare);
+    mem_free(alloc, state.tails);
+    mem_free(alloc, state.previous);
+}
+
+/// Line ids
+//
+// open addressing table shared by both files, every distinct line hash gets the next id.
+// slots only keep 32 bits of the hash next to the id, so probing stays in a flat 8 byte array
+// and the full hash is checked against the dense id -> hash array only when the tag matches.
+
+struct Line_Slot {
+    u32 tag;
+    u32 id; // id + 1, 0 is an empty slot
+};
+
+struct Line_Interner {
+    Line_Slot *slots;
+    u64        mask;
+
+    Hash128 *hashes;
+    u32        count;
+};
+
+b32 interner_create(Line_Interner *interner, u64 max_lines) {
+    Allocator alloc = get_stdlib_allocator();
+
+    if (max_lines == 0) max_lines = 1;
+
+    u64 capacity = 16;
+    while (capacity < max_lines * 2) capacity *= 2;
+
+    *interner = {};
+    interner->slots  = (Line_Slot *)mem_alloc(alloc, capacity * sizeof(Line_Slot));
+    interner->hashes = (Hash128 *)mem_alloc_uninit(alloc, max_lines * sizeof(Hash128));
+    interner->mask   = capacity - 1;
+
+    if (!interner->slots || !interner->hashes) {
+        ERRLOG("Interner: Couldn't create table.");
+        return false;
+    }
+
+    return true;
+}
+
+void interner_delete(Line_Interner *interner) {
+    Allocator alloc = get_stdlib_allocator();
+
+    mem_free(alloc, interner->slots);
+    mem_free(alloc, interner->hashes);
+    *interner = {};
+}
+
+u32 interner_add(Line_Interner *interner, Hash128 hash) {
+    u64 key = hash.low;
+    u32 tag = (u32)hash.high;
+
+    for (u64 slot = key & interner->mask;; slot = (slot + 1) & interner->mask) {
+        Line_Slot *entry = interner->slots + slot;
+
+        if (entry->id == 0) {
+            interner->hashes[interner->count] = hash;
+
+            entry->tag = tag;
+            entry->id  = ++interner->count;
+            return entry->id - 1;
+        }
+
+        if (entry->tag == tag && hash_equal(interner->hashes[entry->id - 1], hash)) {
+            return entry->id - 1;
+        }
+    }
+}
+
+// table has to be created for at least all lines of both files
+List<u32> intern_lines(Line_Interner *interner, List<Hash128> hashes) {
+    List<u32> ids = {};
+
+    if (hashes.count == 0) return ids;
+
+    list_create(&ids, hashes.count);
+
+    for (u64 i = 0; i < hashes.count; i++) {
+        ids.data[i] = interner_add(interner, hashes[i]);
+    }
+
+    ids.count = hashes.count;
+    return ids;
+}
+
+/// Prefix and suffix trimming
+//
+// most diffs are small edits in big files, so the equal head and tail of the id arrays
+// are matched here and only the window between them goes to the engine.
+
+// the wide loops stop at the first differing vector, the byte loops finish the count
+
+static u64 diff_common_prefix_sse2(u32 *origin, u32 *compare, u64 count) {
+    u64 i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i a = _mm_loadu_si128((__m128i *)(origin  + i));
+        __m128i b = _mm_loadu_si128((__m128i *)(compare + i));
+        u32 mask  = (u32)_mm_movemask_epi8(_mm_cmpeq_epi32(a, b));
+
+        if (mask != 0xFFFF) return i + __builtin_ctz(~mask & 0xFFFF) / 4;
+    }
+
+    while (i < count && origin[i] == compare[i]) i++;
+    return i;
+}
+
+TARGET_AVX2 static u64 diff_common_prefix_avx2(u32 *origin, u32 *compare, u64 count) {
+    u64 i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256i a = _mm256_loadu_si256((__m256i *)(origin  + i));
+        __m256i b = _mm256_loadu_si256((__m256i *)(compare + i));
+        u32 mask  = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, b));
+
+        if (mask != 0xFFFFFFFF) return i + __builtin_ctz(~mask) / 4;
+    }
+
+    while (i < count && origin[i] == compare[i]) i++;
+    return i;
+}
+
+static u64 diff_common_suffix_sse2(u32 *origin_end, u32 *compare_end, u64 count) {
+    u64 i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i a = _mm_loadu_si128((__m128i *)(origin_end  - i - 4));
+        __m128i b = _mm_loadu_si128((__m128i *)(compare_end - i - 4));
+        u32 mask  = (u32)_mm_movemask_epi8(_mm_cmpeq_epi32(a, b));
+
+        if (mask != 0xFFFF) return i + (__builtin_clz(~mask & 0xFFFF) - 16) / 4;
+    }
+
+    while (i < count && origin_end[-(s64)i - 1] == compare_end[-(s64)i - 1]) i++;
+    return i;
+}
+
+TARGET_AVX2 static u64 diff_common_suffix_avx2(u32 *origin_end, u32 *compare_end, u64 count) {
+    u64 i = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256i a = _mm256_loadu_si256((__m256i *)(origin_end  - i - 8));
+        __m256i b = _mm256_loadu_si256((__m256i *)(compare_end - i - 8));
+        u32 mask  = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, b));
+
+        if (mask != 0xFFFFFFFF) return i + __builtin_clz(~mask) / 4;
+    }
+
+    while (i < count && origin_end[-(s64)i - 1] == compare_end[-(s64)i - 1]) i++;
+    return i;
+}
+
+// length of the equal run at the start of both arrays
+u64 diff_common_prefix(u32 *origin, u32 *compare, u64 count) {
+    if (cpu_features().avx2) return diff_common_prefix_avx2(origin, compare, count);
+    return diff_common_prefix_sse2(origin, compare, count);
+}
+
+// length of the equal run that ends right before origin_end and compare_end
+u64 diff_common_suffix(u32 *origin_end, u32 *compare_end, u64 count) {
+    if (cpu_features().avx2) return diff_common_suffix_avx2(origin_end, compare_end, count);
+    return diff_common_suffix_sse2(origin_end, compare_end, count);
+}
+
+// find longest common subsequence of lines, id_count is the amount of distinct ids in both files
+Subseq *get_subsequence(List<u32> origin, List<u32> compare, u32 id_count, Diff_Algorithm algorithm, Allocator alloc) {
+    Subseq_List seq = { NULL, NULL, alloc };
+
+    if (origin.count == 0 || compare.count == 0) return NULL;
+
+    u64 limit  = MIN(origin.count, compare.count);
+    u64 prefix = diff_common_prefix(origin.data, compare.data, limit);
+    u64 suffix = diff_common_suffix(origin.data + origin.count, compare.data + compare.count, limit - prefix);
+
+    for (u64 i = 0; i < prefix; i++) {
+        subseq_push_back(&seq, i, i);
+    }
+
+    Diff_Window window = {
+        origin.data,  prefix, origin.count  - prefix - suffix,
+        compare.data, prefix, compare.count - prefix - suffix
+    };
+
+    if (window.origin_count > 0 && window.compare_count > 0) {
+        switch (algorithm) {
+            case DIFF_MYERS:
+                myers_diff_region(window, &seq);
+                break;
+            case DIFF_PATIENCE:
+            case DIFF_HISTOGRAM:
+                anchor_diff(window, id_count, algorithm, &seq);
+                break;
+        }
+    }
+
+    for (u64 i = 0; i < suffix; i++) {
+        subseq_push_back(&seq, origin.count - suffix + i, compare.count - suffix + i);
+    }
+
+    return seq.first;
+}
@@ -0,0 +1,100 @@
+/// Hashing
+//
+// lines and whole files are identified by 128 bit hashes. meow is used when the cpu has
+// aes-ni, everything else gets a portable multiply-mix hash. the kernel is picked once,
+// so every hash of a run comes from the same function and hashes stay comparable.
+
+struct Hash128 {
+    u64 low;
+    u64 high;
+};
+
+static inline b32 hash_equal(Hash128 a, Hash128 b) {
+    return a.low == b.low && a.high == b.high;
+}
+
+/// AES-NI
+
+TARGET_AES static Hash128 hash_meow(u64 size, void *data) {
+    meow_u128 hash = MeowHash(MeowDefaultSeed, size, data);
+
+    Hash128 result;
+    _mm_storeu_si128((__m128i *)&result, hash);
+    return result;
+}
+
+/// Portable fallback
+//
+// two 64 bit lanes, each 16 byte step is folded in with a 64x64 -> 128 multiply.
+// the size goes into the seed, so the zero padded tail can't collide with a longer input.
+
+#define HASH_K0 0xa0761d6478bd642full
+#define HASH_K1 0xe7037ed1a0b428dbull
+#define HASH_K2 0x8ebc6af09c88c6e3ull
+#define HASH_K3 0x589965cc75374cc3ull
+
+static inline u64 hash_mum(u64 a, u64 b) {
+    __uint128_t product = (__uint128_t)a * b;
+    return (u64)product ^ (u64)(product >> 64);
+}
+
+static inline u64 hash_read64(u8 *data) {
+    u64 value;
+    __builtin_memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static Hash128 hash_mix(u64 size, void *data) {
+    u8 *at = (u8 *)data;
+
+    u64 low  = HASH_K0 ^ size;
+    u64 high = HASH_K1 ^ hash_mum(size, HASH_K2);
+
+    u64 left = size;
+
+    for (; left >= 16; left -= 16, at += 16) {
+        u64 a = hash_read64(at);
+        u64 b = hash_read64(at + 8);
+
+        low  = hash_mum(a ^ low,  b ^ HASH_K1);
+        high = hash_mum(b ^ high, a ^ HASH_K3);
+    }
+
+    u64 a = 0;
+    u64 b = 0;
+
+    if (left > 8) {
+        a = hash_read64(at);
+        __builtin_memcpy(&b, at + 8, left - 8);
+    } else if (left > 0) {
+        __builtin_memcpy(&a, at, left);
+    }
+
+    low  = hash_mum(a ^ low,  b ^ HASH_K2);
+    high = hash_mum(b ^ high, a ^ HASH_K0);
+
+    Hash128 result;
+    result.low  = hash_mum(low ^ HASH_K3, high ^ HASH_K1);
+    result.high = hash_mum(high ^ HASH_K2, low ^ HASH_K0 ^ size);
+    return result;
+}
+
+/// Dispatch
+
+typedef Hash128 Hash_Proc(u64 size, void *data);
+
+// picked on the first call, the function static makes that safe from several threads
+static Hash_Proc *hash_kernel(void) {
+    static Hash_Proc *kernel = cpu_features().aes && cpu_features().sse41 ? hash_meow : hash_mix;
+    return kernel;
+}
+
+// picks the kernel at startup, so the first hash doesn't pay for it
+void hash_init(void) {
+    hash_kernel();
+}
+
+Hash128 get_hash(u64 size, void *data) {
+    assert(data != 0);
+    return hash_kernel()(size, data);
+}
@@ -0,0 +1,307 @@
+#include <immintrin.h>
+
+struct Line {
+    u64 start;
+    u64 stop;
+};
+
+/// Line scanning
+//
+// lines end on '\n' or 0. the kernels turn every 64 byte block into a mask of its line
+// breaks, a batch of blocks per call, and the callers walk the set bits, so the input is
+// read at memory speed and the kernel is only picked once per batch.
+
+#define LINE_SCAN_BLOCK 64
+#define LINE_SCAN_BATCH 64
+
+// the last line may end with the file instead of a line break, it is still a line.
+// it stops at the file size, every other line stops on its break.
+static inline b32 line_is_unterminated(String file, Line line) {
+    return line.stop == file.size;
+}
+
+static void line_break_masks_sse2(u8 *data, u64 blocks, u64 *masks) {
+    __m128i newline = _mm_set1_epi8('\n');
+    __m128i zero    = _mm_setzero_si128();
+
+    for (u64 block = 0; block < blocks; block++, data += LINE_SCAN_BLOCK) {
+        u64 mask = 0;
+
+        for (u32 part = 0; part < 4; part++) {
+            __m128i bytes  = _mm_loadu_si128((__m128i *)(data + part * 16));
+            __m128i breaks = _mm_or_si128(_mm_cmpeq_epi8(bytes, newline), _mm_cmpeq_epi8(bytes, zero));
+            mask |= (u64)(u32)_mm_movemask_epi8(breaks) << (part * 16);
+        }
+
+        masks[block] = mask;
+    }
+}
+
+TARGET_AVX2 static void line_break_masks_avx2(u8 *data, u64 blocks, u64 *masks) {
+    __m256i newline = _mm256_set1_epi8('\n');
+    __m256i zero    = _mm256_setzero_si256();
+
+    for (u64 block = 0; block < blocks; block++, data += LINE_SCAN_BLOCK) {
+        __m256i low  = _mm256_loadu_si256((__m256i *)data);
+        __m256i high = _mm256_loadu_si256((__m256i *)(data + 32));
+
+        u32 low_mask  = (u32)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(low,  newline), _mm256_cmpeq_epi8(low,  zero)));
+        u32 high_mask = (u32)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(high, newline), _mm256_cmpeq_epi8(high, zero)));
+
+        masks[block] = ((u64)high_mask << 32) | low_mask;
+    }
+}
+
+typedef void Line_Break_Masks_Proc(u8 *data, u64 blocks, u64 *masks);
+
+static Line_Break_Masks_Proc *line_break_masks_kernel(void) {
+    // function statics are initialized once, even with several scan threads
+    static Line_Break_Masks_Proc *kernel = cpu_features().avx2 ? line_break_masks_avx2 : line_break_masks_sse2;
+    return kernel;
+}
+
+// amount of whole blocks for the next batch starting at offset
+static inline u64 line_scan_blocks(u64 size, u64 offset) {
+    u64 blocks = (size - offset) / LINE_SCAN_BLOCK;
+    return blocks < LINE_SCAN_BATCH ? blocks : LINE_SCAN_BATCH;
+}
+
+// offset right behind the first count lines, the whole file if it has fewer
+u64 find_lines_end(String file, u64 count) {
+    if (count == 0) return 0;
+
+    u64 i = 0;
+
+    Line_Break_Masks_Proc *kernel = line_break_masks_kernel();
+    u64 masks[LINE_SCAN_BATCH];
+
+    for (u64 blocks; (blocks = line_scan_blocks(file.size, i)) > 0;) {
+        kernel(file.data + i, blocks, masks);
+
+        for (u64 block = 0; block < blocks; block++, i += LINE_SCAN_BLOCK) {
+            u64 mask   = masks[block];
+            u64 breaks = __builtin_popcountll(mask);
+
+            if (breaks < count) {
+                count -= breaks;
+                continue;
+            }
+
+            while (--count) mask &= mask - 1;
+            return i + __builtin_ctzll(mask) + 1;
+        }
+    }
+
+    for (; i < file.size; i++) {
+        if ((file.data[i] == '\n' || file.data[i] == 0) && --count == 0) return i + 1;
+    }
+
+    return file.size;
+}
+
+// a line without a break never matches the same text with one,
+// so a newline missing at the end of only one file is a change
+static inline Hash128 get_line_hash(String file, Line line) {
+    Hash128 hash = get_hash(line.stop - line.start, file.data + line.start);
+    if (line_is_unterminated(file, line)) hash.high ^= 0x9e3779b97f4a7c15ull;
+    return hash;
+}
+
+/// Fused scan and hash
+//
+// finds line breaks and hashes every line right after its end is found, while its bytes
+// are still in cache, so the input is streamed from memory once instead of twice.
+
+struct Hashed_Lines {
+    List<Line>      lines;
+    List<Hash128> hashes;
+};
+
+static inline void push_hashed_line(Hashed_Lines *output, String file, u64 start, u64 stop) {
+    if (output->lines.count == output->lines.capacity)   list_grow(&output->lines, 1);
+    if (output->hashes.count == output->hashes.capacity) list_grow(&output->hashes, 1);
+
+    output->lines.data[output->lines.count++]   = { start, stop };
+    output->hashes.data[output->hashes.count++] = get_line_hash(file, { start, stop });
+}
+
+// scans file[from, size) and adds every line that ends on a break in it, start is where the
+// line open at from began. returns where the line that is still open at the end begins.
+static u64 scan_and_hash_range(Hashed_Lines *output, String file, u64 start, u64 from) {
+    u64 i = from;
+
+    Line_Break_Masks_Proc *kernel = line_break_masks_kernel();
+    u64 masks[LINE_SCAN_BATCH];
+
+    for (u64 blocks; (blocks = line_scan_blocks(file.size, i)) > 0;) {
+        kernel(file.data + i, blocks, masks);
+
+        for (u64 block = 0; block < blocks; block++, i += LINE_SCAN_BLOCK) {
+            u64 mask = masks[block];
+
+            while (mask) {
+                u64 stop = i + __builtin_ctzll(mask);
+                push_hashed_line(output, file, start, stop);
+                start = stop + 1;
+                mask &= mask - 1;
+            }
+        }
+    }
+
+    for (; i < file.size; i++) {
+        if (!(file.data[i] == '\n' || file.data[i] == 0)) {
+            continue;
+        }
+
+        push_hashed_line(output, file, start, i);
+        start = i + 1;
+    }
+
+    return start;
+}
+
+// adds the line still open at the end of the file, if it has any bytes
+static void finish_hashed_lines(Hashed_Lines *output, String file, u64 start) {
+    if (start < file.size) push_hashed_line(output, file, start, file.size);
+}
+
+Hashed_Lines scan_and_hash_lines(String file) {
+    Hashed_Lines output = {};
+
+    // guess for the line count, lists grow if the lines are shorter
+    u64 estimate = file.size / 64 + STANDART_LIST_SIZE;
+
+    if (!list_create(&output.lines, estimate) || !list_create(&output.hashes, estimate)) {
+        return output;
+    }
+
+    u64 start = scan_and_hash_range(&output, file, 0, 0);
+    finish_hashed_lines(&output, file, start);
+
+    return output;
+}
+
+/// Incremental scan and hash
+//
+// inputs without a size (pipes, stdin) come in chunk by chunk. every chunk is scanned and
+// hashed as soon as it is in, so the hashing runs alongside the producer instead of after it.
+
+struct Incremental_Scan {
+    Hashed_Lines result;
+
+    u64 start;   // where the line that is still open began
+    u64 scanned; // bytes scanned so far
+};
+
+b32 incremental_scan_create(Incremental_Scan *scan) {
+    *scan = {};
+    return list_create(&scan->result.lines, STANDART_LIST_SIZE) && list_create(&scan->result.hashes, STANDART_LIST_SIZE);
+}
+
+// Input_Chunk_Proc, data is everything read so far and may have moved since the last chunk
+void incremental_scan_proc(String data, void *user) {
+    Incremental_Scan *scan = (Incremental_Scan *)user;
+
+    scan->start   = scan_and_hash_range(&scan->result, data, scan->start, scan->scanned);
+    scan->scanned = data.size;
+}
+
+// data is the whole input once it's read
+void incremental_scan_finish(Incremental_Scan *scan, String data) {
+    finish_hashed_lines(&scan->result, data, scan->start);
+}
+
+/// Parallel scan and hash
+//
+// splits the file right after line breaks into one chunk per thread, runs the fused
+// pass on every chunk and stitches the results back in order.
+
+#define PARALLEL_SCAN_MIN_SIZE MB(8)
+#define PARALLEL_SCAN_MAX_THREADS 64
+
+struct Scan_Chunk {
+    String       file;
+    u64          offset;
+    Hashed_Lines result;
+};
+
+static void scan_chunk_proc(void *data) {
+    Scan_Chunk *chunk = (Scan_Chunk *)data;
+    chunk->result = scan_and_hash_lines(chunk->file);
+}
+
+Hashed_Lines scan_and_hash_lines(String file, u32 threads) {
+    if (threads > PARALLEL_SCAN_MAX_THREADS) threads = PARALLEL_SCAN_MAX_THREADS;
+
+    if (threads <= 1 || file.size < PARALLEL_SCAN_MIN_SIZE) {
+        return scan_and_hash_lines(file);
+    }
+
+    Scan_Chunk chunks[PARALLEL_SCAN_MAX_THREADS]  = {};
+    Thread     workers[PARALLEL_SCAN_MAX_THREADS] = {};
+
+    u64 chunk_size = file.size / threads;
+    u64 begin      = 0;
+    u32 count      = 0;
+
+    for (u32 i = 0; i < threads && begin < file.size; i++) {
+        u64 end = file.size;
+
+        if (i + 1 < threads) {
+            end = MAX(begin, (i + 1) * chunk_size);
+
+            while (end < file.size && !(file.data[end] == '\n' || file.data[end] == 0)) {
+                end++;
+            }
+
+            if (end < file.size) end++;
+        }
+
+        chunks[count].file   = { end - begin, file.data + begin };
+        chunks[count].offset = begin;
+        count++;
+
+        begin = end;
+    }
+
+    // the calling thread takes the first chunk
+    for (u32 i = 1; i < count; i++) {
+        if (!platform_thread_start(&workers[i], scan_chunk_proc, &chunks[i])) {
+            scan_chunk_proc(&chunks[i]);
+            workers[i].proc = NULL;
+        }
+    }
+
+    scan_chunk_proc(&chunks[0]);
+
+    u64 total = 0;
+
+    for (u32 i = 0; i < count; i++) {
+        if (i > 0 && workers[i].proc) platform_thread_join(&workers[i]);
+        total += chunks[i].result.lines.count;
+    }
+
+    Hashed_Lines output = {};
+
+    if (!list_create(&output.lines, MAX(total, 1)) || !list_create(&output.hashes, MAX(total, 1))) {
+        return output;
+    }
+
+    for (u32 i = 0; i < count; i++) {
+        Hashed_Lines *result = &chunks[i].result;
+        u64 offset = chunks[i].offset;
+
+        for (u64 line = 0; line < result->lines.count; line++) {
+            Line chunk_line = result->lines[line];
+            output.lines.data[output.lines.count++] = { chunk_line.start + offset, chunk_line.stop + offset };
+        }
+
+        mem_copy((u8 *)(output.hashes.data + output.hashes.count), (u8 *)result->hashes.data, result->hashes.count * sizeof(Hash128));
+        output.hashes.count += result->hashes.count;
+
+        list_delete(&result->lines);
+        list_delete(&result->hashes);
+    }
+
+    return output;
+}
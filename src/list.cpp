@@ -1,15 +1,16 @@
 #pragma once
 
-#define ALLOC(x)      calloc(1, x) 
-#define FREE(x)       free(x) 
 #define STANDART_LIST_SIZE 64
 
+// lists without an allocator (zero initialized ones) use the stdlib allocator,
+// growth goes through ALLOCATOR_REALLOCATE so big lists can be extended in place
 template<typename DataType>
 struct List {
     u64 count;
     DataType *data;
 
     u64 capacity;
+    Allocator alloc;
 
     DataType& operator[](u64 index) {
         return data[index];
@@ -19,7 +20,7 @@ struct List {
 // ----------- Initialization 
 
 template<typename DataType>
-b32 list_create(List<DataType> *list, u64 init_size);
+b32 list_create(List<DataType> *list, u64 init_size, Allocator alloc = get_stdlib_allocator());
 template<typename DataType>
 List<DataType> list_clone(List<DataType> *list);
 template<typename DataType>
@@ -48,16 +49,17 @@ DataType *list_get(List<DataType> *list, u64 index);
 // ----------- Helpers
 
 template<typename DataType>
-b32 list_grow(List<DataType> *list);
+b32 list_grow(List<DataType> *list, u64 fit_elements);
 
 // ----------- Implementation
 
 template<typename DataType>
-b32 list_create(List<DataType> *list, u64 init_size) {
-    list->count        = 0;
+b32 list_create(List<DataType> *list, u64 init_size, Allocator alloc) {
+    list->count    = 0;
     list->capacity = init_size;
+    list->alloc    = alloc;
 
-    list->data      = (DataType*)ALLOC(init_size * sizeof(DataType));
+    list->data      = (DataType*)mem_alloc_uninit(alloc, init_size * sizeof(DataType));
 
     if (list->data == NULL) {
         ERRLOG("List: Couldn't create list.");
@@ -74,10 +76,10 @@ List<DataType> list_clone(List<DataType> *list) {
     if (list->capacity == 0)
         return {};
 
-    if (!list_create(&clone, list->capacity))
+    if (!list_create(&clone, list->capacity, list->alloc))
         return {};
 
-    mem_copy((u8*)clone.data, (u8*)list->data, sizeof(List<DataType>) * list->count);
+    mem_copy((u8*)clone.data, (u8*)list->data, sizeof(DataType) * list->count);
     clone.count = list->count;
 
     return clone;
@@ -95,7 +97,7 @@ b32 list_delete(List<DataType> *list) {
         return false;
     }
 
-    FREE(list->data); 
+    mem_free(list->alloc, list->data); 
     list->data = NULL;
 
     return true;
@@ -153,7 +155,7 @@ DataType *list_get(List<DataType> *list, u64 index) {
     if (!list->data) return NULL;
 
     if (index >= list->count) {
-        ERRLOG("List: Bounce check failed. accessed: %llu, size: %llu", index, list->count);
+        ERRLOG("List: Bounce check failed. accessed: %llu, size: %llu", (unsigned long long)index, (unsigned long long)list->count);
         return NULL;
     }
 
@@ -165,7 +167,7 @@ DataType *list_get(List<DataType> *list, u64 index) {
 template<typename DataType>
 void list_create_if_needed(List<DataType> *list) {
     if (list->data) return;
-    if (list_create(list, STANDART_LIST_SIZE)) return;
+    if (list_create(list, STANDART_LIST_SIZE, list->alloc.proc ? list->alloc : get_stdlib_allocator())) return;
 
     ERRLOG("tried to create list but failed.");
 }
@@ -177,23 +179,23 @@ b32 list_grow(List<DataType> *list, u64 fit_elements) {
 
     if ((list->count + fit_elements - 1) < list->capacity) {
         return true;
-    } else while ((list->count + fit_elements) >= list->capacity) {
-        DataType *data = (DataType*)ALLOC(list->capacity * 2 * sizeof(DataType));
+    }
 
-        if (!data) {
-            ERRLOG("List: Couldn't grow list.");
-            return false;
-        }
+    u64 new_capacity = list->capacity;
 
-        u64 new_capacity = list->capacity * 2;
+    while ((list->count + fit_elements) >= new_capacity) {
+        new_capacity *= 2;
+    }
 
-        mem_set((u8*)data, 0, new_capacity * sizeof(DataType));
-        mem_copy((u8*)data, (u8*)list->data, list->capacity * sizeof(DataType));
+    DataType *data = (DataType*)mem_realloc(list->alloc, list->data, new_capacity * sizeof(DataType));
 
-        FREE(list->data);
-        list->data = data;
-        list->capacity = new_capacity;
+    if (!data) {
+        ERRLOG("List: Couldn't grow list.");
+        return false;
     }
 
+    list->data = data;
+    list->capacity = new_capacity;
+
     return true;
 }
@@ -1,249 +1,1258 @@
 #include <stdio.h>
 
 #include "core.cpp"
+#include "platform.cpp"
+#include "output.cpp"
+#include "diff.cpp"
+#include "lines.cpp"
+#include "tree.cpp"
+#include "renames.cpp"
 
-struct Subseq {
-    u64 origin_index;
-    u64 compare_index;
-    Subseq *next;
-};
+// size first, then one hash per buffer, so equal files never get split into lines
+b32 files_are_identical(String origin, String compare) {
+    if (origin.size != compare.size) return false;
+    if (origin.size == 0) return true;
 
-struct Line {
-    u64 start;
-    u64 stop;
-};
+    Hash128 origin_hash  = get_hash(origin.size, origin.data);
+    Hash128 compare_hash = get_hash(compare.size, compare.data);
+
+    return hash_equal(origin_hash, compare_hash);
+}
+
+// like gnu diff, a last line that ends without a line break is followed by a note
+void print_missing_newline(Output *output, String file, Line line) {
+    if (line_is_unterminated(file, line)) output_write(output, STR("\\ No newline at end of file\n"));
+}
+
+void print_line(Output *output, String prefix, String file, Line line) {
+    output_write(output, prefix);
+
+    if (line.start != line.stop) {
+        String l = {
+            .size = line.stop - line.start, // @todo, as we on windows, we have \r also, so we need to delete it too
+            .data = file.data + line.start
+        };
+
+        output_write(output, l);
+    }
+
+    output_write(output, (u8)'\n');
+
+    print_missing_newline(output, file, line);
+}
 
-enum Compare_State {
-    COMPARE_END,
-    COMPARE_NOT_FOUND,
-    COMPARE_FOUND,
+struct Diff_Side {
+    char      *path;
+    String     file;
+    List<Line> lines;
+
+    // streams are printed a window at a time, the number of the first line
+    // and whether more lines follow the window
+    u64 line_base;
+    b32 partial;
 };
 
-// find longest distance in string
-Subseq *get_subsequence(List<meow_u128> origin, List<meow_u128> compare, Allocator alloc) {
-    Subseq *seq = NULL;
-    Subseq *curr;
-    u64 last_index = 0;
+void print_full(Output *output, Diff_Side *origin, Diff_Side *compare, Subseq *begin) {
+    { // print origin file
+        Subseq *temp = begin;
+        output_write(output, STR("> "));
+        output_write(output, STR(origin->path));
+        output_write(output, (u8)'\n');
+
+        for (u64 i = 0; i < origin->lines.count; i++) {
+            if (temp && temp->origin_index == i) {
+                print_line(output, STR("  "), origin->file, origin->lines[i]);
+                temp = temp->next;
+            } else {
+                print_line(output, STR("- "), origin->file, origin->lines[i]);
+            }
+        }
+    }
 
-    b32 started = false;
+    output_write(output, (u8)'\n');
 
-    for (u64 origin_index = 0; origin_index < origin.count; origin_index++) {
-        Subseq temp = {};
-        temp.origin_index = origin_index;
+    { // print compared file
+        Subseq *temp = begin;
+        output_write(output, STR("> "));
+        output_write(output, STR(compare->path));
+        output_write(output, (u8)'\n');
 
-        Compare_State found = COMPARE_END;
-        for (u64 compare_index = last_index; compare_index < compare.count; compare_index++) {
-            // @todo also check lines for hash failure
-            if (!MeowHashesAreEqual(compare[compare_index], origin[origin_index])) {
-                found = COMPARE_NOT_FOUND; 
-                continue;
+        for (u64 i = 0; i < compare->lines.count; i++) {
+            if (temp && temp->compare_index == i) {
+                print_line(output, STR("  "), compare->file, compare->lines[i]);
+                temp = temp->next;
+            } else {
+                print_line(output, STR("+ "), compare->file, compare->lines[i]);
             }
+        }
+    }
+}
 
-            found = COMPARE_FOUND;
-            temp.compare_index = compare_index;
-            last_index = compare_index + 1;
-            break;
+/// Unified output
+//
+// the Subseq list is walked once and turned into changes, the gaps between matched pairs.
+// changes closer than 2 * context lines share a hunk.
+
+struct Change {
+    u64 origin_start;
+    u64 origin_stop;
+    u64 compare_start;
+    u64 compare_stop;
+};
+
+void print_unified_line(Output *output, u8 prefix, String file, Line line) {
+    output_write(output, prefix);
+    output_write(output, { line.stop - line.start, file.data + line.start });
+    output_write(output, (u8)'\n');
+
+    // patch would add the newline otherwise
+    print_missing_newline(output, file, line);
+}
+
+void print_hunk_range(Output *output, u64 start, u64 count) {
+    // empty ranges point at the line before them
+    output_write(output, count == 0 ? start : start + 1);
+    output_write(output, (u8)',');
+    output_write(output, count);
+}
+
+void print_hunk(Output *output, Diff_Side *origin, Diff_Side *compare, List<Change> changes, u64 context) {
+    Change first = changes[0];
+    Change last  = changes[changes.count - 1];
+
+    u64 before = MIN(context, MIN(first.origin_start, first.compare_start));
+    u64 after  = MIN(context, MIN(origin->lines.count - last.origin_stop, compare->lines.count - last.compare_stop));
+
+    // patch reads less context after a hunk than before it as the end of the file,
+    // a hunk cut off by the end of a window can't have more before it
+    if ((origin->partial || compare->partial) && before > after) before = after;
+
+    u64 origin_start  = first.origin_start  - before;
+    u64 compare_start = first.compare_start - before;
+
+    output_write(output, STR("@@ -"));
+    print_hunk_range(output, origin->line_base + origin_start, last.origin_stop + after - origin_start);
+    output_write(output, STR(" +"));
+    print_hunk_range(output, compare->line_base + compare_start, last.compare_stop + after - compare_start);
+    output_write(output, STR(" @@\n"));
+
+    u64 at = origin_start;
+
+    for (u64 i = 0; i < changes.count; i++) {
+        Change change = changes[i];
+
+        for (; at < change.origin_start; at++) {
+            print_unified_line(output, ' ', origin->file, origin->lines[at]);
         }
-        
-        switch (found) {
-            case COMPARE_END:
-            case COMPARE_NOT_FOUND:
-                break;
 
-            case COMPARE_FOUND:
-                if (!started) {
-                    started = true;
-                    seq = (Subseq *)mem_alloc(alloc, sizeof(Subseq));
-                    assert(seq);
-                    curr = seq;
-                } else {
-                    curr->next = (Subseq *)mem_alloc(alloc, sizeof(Subseq));
-                    curr = curr->next;
-                }
+        for (u64 line = change.origin_start; line < change.origin_stop; line++) {
+            print_unified_line(output, '-', origin->file, origin->lines[line]);
+        }
 
-                *curr = temp;
-                break;
+        for (u64 line = change.compare_start; line < change.compare_stop; line++) {
+            print_unified_line(output, '+', compare->file, compare->lines[line]);
         }
+
+        at = change.origin_stop;
     }
 
-    return seq;
+    for (; at < last.origin_stop + after; at++) {
+        print_unified_line(output, ' ', origin->file, origin->lines[at]);
+    }
 }
 
-meow_u128 get_hash(u64 size, void *data) {
-    // assert(size > 0);
-    assert(data != 0);
-    return MeowHash(MeowDefaultSeed, size, data);
-    //
-    // u32 hash = 216613261u;
-    //
-    // u8* arr = (u8*)data;
-    // for (u64 i = 0; i < size; i++) {
-    //     hash ^= arr[i];
-    //     hash *= 0x1000193;
-    // }
-    //
-    // return hash;
+// header is set once the file names are printed, streams print one diff in several calls
+void print_unified(Output *output, Diff_Side *origin, Diff_Side *compare, Subseq *begin, u64 context, b32 *header = NULL) {
+    List<Change> changes = {};
+
+    u64 origin_index  = 0;
+    u64 compare_index = 0;
+
+    b32 printed = false;
+    if (!header) header = &printed;
+
+    for (Subseq *temp = begin;; temp = temp->next) {
+        u64 origin_match  = temp ? temp->origin_index  : origin->lines.count;
+        u64 compare_match = temp ? temp->compare_index : compare->lines.count;
+
+        if (origin_match > origin_index || compare_match > compare_index) {
+            Change change = { origin_index, origin_match, compare_index, compare_match };
+
+            if (changes.count > 0 && change.origin_start - changes[changes.count - 1].origin_stop > 2 * context) {
+                print_hunk(output, origin, compare, changes, context);
+                changes.count = 0;
+            }
+
+            if (!*header) {
+                *header = true;
+                output_write(output, STR("--- "));
+                output_write(output, STR(origin->path));
+                output_write(output, STR("\n+++ "));
+                output_write(output, STR(compare->path));
+                output_write(output, (u8)'\n');
+            }
+
+            list_add(&changes, change);
+        }
+
+        if (!temp) break;
+
+        origin_index  = origin_match + 1;
+        compare_index = compare_match + 1;
+    }
+
+    if (changes.count > 0) {
+        print_hunk(output, origin, compare, changes, context);
+    }
+
+    if (changes.data) list_delete(&changes);
 }
 
-b32 platform_read_file_into_string(String filename, Allocator alloc, String *output) {
-    assert(output != NULL);
-    assert(filename.data != NULL);
-    assert(filename.size > 0);
+struct Options {
+    Diff_Algorithm algorithm;
+    u32            threads;
 
-    FILE *file = fopen(string_to_c_string(filename, get_temporary_allocator()), "rb");
+    b32 unified;
+    u64 context;
 
-    if (file == NULL) {
-        ERRLOG("Could not open file. %.*s", (int)filename.size, filename.data);
-        return false;
+    // same size and modification time count as identical without reading the files
+    b32 trust_mtime;
+
+    // minimal similarity in percent for renames and copies in directory mode, 0 is off
+    u32 rename_similarity;
+    u32 copy_similarity;
+
+    // files are diffed in windows that fit in this many bytes instead of being read whole, 0 is off
+    u64 memory;
+
+    char *origin_path;
+    char *compare_path;
+};
+
+// more threads than this only cost memory and start up time
+#define OPTION_MAX_THREADS 1024
+
+// already more context than files have lines, and hunks can add it up without overflowing
+#define OPTION_MAX_CONTEXT (1ull << 32)
+
+// plain decimal numbers, without a sign or anything behind them
+static b32 parse_number(char *text, u64 *number) {
+    if (*text < '0' || *text > '9') return false;
+
+    char *end = NULL;
+    errno = 0;
+    u64 value = strtoull(text, &end, 10);
+
+    if (*end != 0 || errno == ERANGE) return false;
+
+    *number = value;
+    return true;
+}
+
+// byte counts like 512M or 2G, without a suffix they are bytes
+static b32 parse_size(char *text, u64 *size) {
+    // strtoull would take a sign and wrap negative values around
+    if (*text < '0' || *text > '9') return false;
+
+    char *end = NULL;
+    errno = 0;
+    u64 value = strtoull(text, &end, 10);
+
+    if (errno == ERANGE) return false;
+
+    u32 shift = 0;
+
+    switch (*end) {
+        case 'k': case 'K': shift = 10; end++; break;
+        case 'm': case 'M': shift = 20; end++; break;
+        case 'g': case 'G': shift = 30; end++; break;
     }
 
-    fseek(file, 0L, SEEK_END);
-    u64 file_size = ftell(file);
-    rewind(file);
+    if (*end != 0 || value > (~0ull >> shift)) return false;
 
-    if (file_size == 0) {
-        fclose(file);
-        return false;
+    *size = value << shift;
+    return true;
+}
+
+b32 parse_options(int argc, char **argv, Options *options) {
+    u64 paths = 0;
+
+    for (int i = 1; i < argc; i++) {
+        String arg = STR(argv[i]);
+
+        if (!string_compare(arg, STR("--myers"))) {
+            options->algorithm = DIFF_MYERS;
+        } else if (!string_compare(arg, STR("--patience"))) {
+            options->algorithm = DIFF_PATIENCE;
+        } else if (!string_compare(arg, STR("--histogram"))) {
+            options->algorithm = DIFF_HISTOGRAM;
+        } else if (!string_compare(arg, STR("-u"))) {
+            options->unified = true;
+        } else if (!string_compare(arg, STR("-U"))) {
+            if (++i >= argc) return false;
+
+            u64 context = 0;
+
+            if (!parse_number(argv[i], &context)) {
+                ERRLOG("context has to be a number of lines: %s\n", argv[i]);
+                return false;
+            }
+
+            options->unified = true;
+            options->context = MIN(context, (u64)OPTION_MAX_CONTEXT);
+        } else if (arg.size >= 2 && arg.data[0] == '-' && (arg.data[1] == 'M' || arg.data[1] == 'C')) {
+            // -M[n] and -C[n] like git, copies imply renames
+            u64 similarity = RENAME_DEFAULT_SIMILARITY;
+
+            if (arg.size > 2 && (!parse_number(argv[i] + 2, &similarity) || similarity == 0 || similarity > 100)) {
+                ERRLOG("similarity has to be a number within 1..100: %s\n", argv[i]);
+                return false;
+            }
+
+            if (arg.data[1] == 'C') {
+                options->copy_similarity = (u32)similarity;
+                if (options->rename_similarity == 0) options->rename_similarity = (u32)similarity;
+            } else {
+                options->rename_similarity = (u32)similarity;
+            }
+        } else if (!string_compare(arg, STR("--trust-mtime"))) {
+            options->trust_mtime = true;
+        } else if (!string_compare(arg, STR("--memory"))) {
+            if (++i >= argc) return false;
+
+            if (!parse_size(argv[i], &options->memory) || options->memory < MB(1)) {
+                ERRLOG("memory has to be a size of at least 1M, like 512M or 2G: %s\n", argv[i]);
+                return false;
+            }
+        } else if (!string_compare(arg, STR("-j")) || !string_compare(arg, STR("--threads"))) {
+            if (++i >= argc) return false;
+
+            u64 threads = 0;
+
+            if (!parse_number(argv[i], &threads) || threads == 0) {
+                ERRLOG("threads has to be a number of at least 1: %s\n", argv[i]);
+                return false;
+            }
+
+            options->threads = (u32)MIN(threads, (u64)OPTION_MAX_THREADS);
+        } else if (arg.size > 1 && arg.data[0] == '-') {
+            ERRLOG("unknown option: %s\n", argv[i]);
+            return false;
+        } else if (paths == 0) {
+            options->origin_path = argv[i];
+            paths++;
+        } else if (paths == 1) {
+            options->compare_path = argv[i];
+            paths++;
+        } else {
+            return false;
+        }
     }
 
-    output->data = (u8*)mem_alloc(alloc, file_size);
+    return paths == 2;
+}
+
+/// Diffing hashed lines
+
+// counts how many lines could match at all, every id as often as the side with less of it has it
+static u64 count_common_lines(List<u32> origin_ids, List<u32> compare_ids, u32 id_count) {
+    Allocator alloc = get_stdlib_allocator();
+
+    u32 *counts = (u32 *)mem_alloc(alloc, (u64)id_count * 2 * sizeof(u32));
+    if (!counts) return ~0ull;
+
+    for (u64 i = 0; i < origin_ids.count;  i++) counts[origin_ids.data[i] * 2]++;
+    for (u64 i = 0; i < compare_ids.count; i++) counts[compare_ids.data[i] * 2 + 1]++;
 
-    u64 bytes_read = fread(output->data, sizeof(u8), file_size, file);
+    u64 common = 0;
 
-    if (bytes_read < file_size) {
-        ERRLOG("Could not read file. %.*s", (int)filename.size, filename.data);
-        fclose(file);
+    for (u64 id = 0; id < id_count; id++) {
+        u32 origin  = counts[id * 2];
+        u32 compare = counts[id * 2 + 1];
+        common += origin < compare ? origin : compare;
+    }
+
+    mem_free(alloc, counts);
+    return common;
+}
+
+// interns both hash lists, frees them and diffs the ids, the subsequence comes from alloc.
+// when fewer than min_common lines could match, the diff is skipped and begin stays empty.
+b32 diff_hashes(Options *options, List<Hash128> *origin_hashes, List<Hash128> *compare_hashes, Allocator alloc, Subseq **begin, u64 min_common = 0) {
+    Line_Interner interner = {};
+
+    *begin = NULL;
+
+    if (!interner_create(&interner, origin_hashes->count + compare_hashes->count)) {
         return false;
     }
 
-    output->size = file_size;
-    fclose(file);
+    List<u32> origin_ids  = intern_lines(&interner, *origin_hashes);
+    List<u32> compare_ids = intern_lines(&interner, *compare_hashes);
+
+    list_delete(origin_hashes);
+    list_delete(compare_hashes);
+
+    if (min_common == 0 || count_common_lines(origin_ids, compare_ids, interner.count) >= min_common) {
+        *begin = get_subsequence(origin_ids, compare_ids, interner.count, options->algorithm, alloc);
+    }
+
+    interner_delete(&interner);
+
+    if (origin_ids.data)  list_delete(&origin_ids);
+    if (compare_ids.data) list_delete(&compare_ids);
+
     return true;
 }
 
-List<Line> scan_lines(String file) {
-    List<Line> lines = {};
-    Line line = {};
+/// Streaming diff
+//
+// for files bigger than memory. both files are read into windows of a fixed size and the
+// windows are diffed on their own. a window's diff is only trusted up to its last run of
+// matching lines that is long enough to keep hunks apart: everything before the run is
+// printed and dropped, the rest moves to the front and the window is filled up behind it.
+//
+// a window without such a run sits in a change bigger than the window. regular files are
+// then searched ahead, hashes only, for the first lines of the other side's window. where
+// they show up, the lines before them are printed as one insertion or deletion, so the
+// files line up again. otherwise both windows are printed whole, which is a valid diff,
+// just not a minimal one. the full listing needs all of the origin before the compare
+// side, so streams are always printed unified.
 
-    for (u64 i = 0; i < file.size; i++) {
-        if (!(file.data[i] == '\n' || file.data[i] == 0)) {
-            continue;
+// an eighth of the budget goes to the bytes of each window and a quarter to its lines, a line
+// pays for its Line, hash, id, interner slots and diff state. the last quarter is the myers trace.
+#define STREAM_LINE_COST 128
+
+// shortest run of matching lines a window is cut at, also the run searched ahead for
+#define STREAM_MIN_ANCHOR 8
+
+// how far ahead a file is searched, in windows
+#define STREAM_LOOKAHEAD 16
+
+struct Stream_Side {
+    Input_Stream input;
+
+    u8 *buffer;
+    u64 capacity;
+    u64 size;
+    u64 offset; // file offset of the buffer
+
+    u64 max_lines;
+    u64 line_base;
+
+    // lines that are printed without diffing, the other file continues after them
+    u64 pending;
+};
+
+// fills the buffer and returns the whole lines in it that fit the line budget.
+// a line that doesn't fit in the buffer grows it.
+static b32 stream_window(Stream_Side *side, char *path, String *window) {
+    for (;;) {
+        u64 read_size = 0;
+
+        if (!platform_stream_read(&side->input, side->buffer + side->size, side->capacity - side->size, &read_size)) {
+            ERRLOG("Could not read file. %s\n", path);
+            return false;
         }
 
-        line.stop  = i;
-        list_add(&lines, line);
-        line.start = i + 1;
+        side->size += read_size;
+
+        u64 end = side->size;
+
+        if (!side->input.eof) {
+            while (end > 0 && !(side->buffer[end - 1] == '\n' || side->buffer[end - 1] == 0)) end--;
+        }
+
+        if (end > 0 || side->input.eof) {
+            *window = { find_lines_end({ end, side->buffer }, side->max_lines), side->buffer };
+            return true;
+        }
+
+        u8 *buffer = (u8 *)mem_realloc(get_stdlib_allocator(), side->buffer, side->capacity * 2);
+
+        if (!buffer) {
+            ERRLOG("Couldn't grow the window for a long line. %s\n", path);
+            return false;
+        }
+
+        side->buffer    = buffer;
+        side->capacity *= 2;
     }
+}
+
+// drops the first count lines of the window from the buffer
+static void stream_advance(Stream_Side *side, List<Line> lines, u64 count) {
+    if (count == 0) return;
+
+    // the last line of the file may have no break to step over
+    u64 consumed = MIN(lines[count - 1].stop + 1, side->size);
 
-    return lines;
+    __builtin_memmove(side->buffer, side->buffer + consumed, side->size - consumed);
+    side->size      -= consumed;
+    side->offset    += consumed;
+    side->line_base += count;
 }
 
-List<meow_u128> get_hashed_lines(String file, List<Line> lines) {
-    List<meow_u128> hashes;
+// the cut goes context lines before the end of the last run of at least min_run matches,
+// so the hunks on both sides of it keep their context and can't merge across it
+static b32 stream_find_cut(Subseq *begin, u64 min_run, u64 context, u64 *origin_cut, u64 *compare_cut) {
+    b32 found = false;
+    u64 run   = 0;
 
-    list_create(&hashes, lines.count);
+    for (Subseq *temp = begin, *previous = NULL; temp; previous = temp, temp = temp->next) {
+        b32 adjacent = previous && temp->origin_index == previous->origin_index + 1 && temp->compare_index == previous->compare_index + 1;
+        run = adjacent ? run + 1 : 1;
 
-    for (u64 line_index = 0; line_index < lines.count; line_index++) {
-        Line line = lines[line_index];
-        meow_u128 hash = get_hash(line.stop - line.start, file.data + line.start);
-        list_add(&hashes, hash);
+        if (run >= min_run) {
+            *origin_cut  = temp->origin_index  + 1 - context;
+            *compare_cut = temp->compare_index + 1 - context;
+            found = true;
+        }
     }
 
-    return hashes;
+    return found;
 }
 
-List<meow_u128> get_hashed_lines(String file) {
-    List<Line> lines = scan_lines(file);
-    List<meow_u128> hashes;
+// searches the file from the start of the window for the lines hashed in run, distance is the
+// line they start at. stops after max_distance lines, only regular files can be read ahead.
+static b32 stream_find_run(Stream_Side *side, Hash128 *run, u64 count, u64 max_distance, u64 *distance) {
+    if (!side->input.seekable || count == 0) return false;
+
+    Allocator alloc = get_stdlib_allocator();
+
+    // a small chunk, its lines are hashed in one go and their lists count against the budget too
+    u64 capacity = MAX(side->capacity / 64, (u64)KB(4));
+    u8 *chunk    = (u8 *)mem_alloc_uninit(alloc, capacity);
+    Hash128 *ring = (Hash128 *)mem_alloc_uninit(alloc, count * sizeof(Hash128));
 
-    list_create(&hashes, lines.count);
+    u64 offset = side->offset;
+    u64 limit  = side->offset + side->capacity * STREAM_LOOKAHEAD;
+    u64 size   = 0;
+    u64 line   = 0;
 
-    for (u64 line_index = 0; line_index < lines.count; line_index++) {
-        Line line = lines[line_index];
-        meow_u128 hash = get_hash(line.stop - line.start, file.data + line.start);
-        list_add(&hashes, hash);
+    b32 found = false;
+    b32 eof   = false;
+
+    while (chunk && ring && !found && !eof && offset < limit && (line < count || line - count < max_distance)) {
+        u64 read_size = 0;
+        if (!platform_stream_read_at(&side->input, offset + size, chunk + size, capacity - size, &read_size)) break;
+
+        size += read_size;
+        eof   = size < capacity;
+
+        u64 end = size;
+
+        if (!eof) {
+            while (end > 0 && !(chunk[end - 1] == '\n' || chunk[end - 1] == 0)) end--;
+        }
+
+        if (end == 0 && !eof) {
+            u8 *grown = (u8 *)mem_realloc(alloc, chunk, capacity * 2);
+            if (!grown) break;
+
+            chunk     = grown;
+            capacity *= 2;
+            continue;
+        }
+
+        Hashed_Lines scan = scan_and_hash_lines({ end, chunk });
+
+        for (u64 i = 0; i < scan.hashes.count && !found; i++, line++) {
+            Hash128 hash = scan.hashes[i];
+            ring[line % count] = hash;
+
+            if (line + 1 < count || !hash_equal(hash, run[count - 1])) continue;
+
+            found = true;
+
+            for (u64 j = 0; j < count && found; j++) {
+                found = hash_equal(ring[(line + 1 - count + j) % count], run[j]);
+            }
+
+            if (found) *distance = line + 1 - count;
+        }
+
+        if (scan.lines.data)  list_delete(&scan.lines);
+        if (scan.hashes.data) list_delete(&scan.hashes);
+
+        __builtin_memmove(chunk, chunk + end, size - end);
+        size   -= end;
+        offset += end;
     }
 
-    return hashes;
+    if (chunk) mem_free(alloc, chunk);
+    if (ring)  mem_free(alloc, ring);
+
+    return found && *distance <= max_distance;
 }
 
-void print_line(String file, Line line) {
-    if (line.start == line.stop) return;
+// hashes up to STREAM_MIN_ANCHOR lines from first on, the run the other file is searched for
+static u64 stream_hash_head(String window, List<Line> lines, u64 first, Hash128 *head) {
+    u64 count = 0;
 
-    String l = {
-        .size = line.stop - line.start, // @todo, as we on windows, we have \r also, so we need to delete it too
-        .data = file.data + line.start
-    };
+    for (u64 i = first; i < lines.count && count < STREAM_MIN_ANCHOR; i++) {
+        head[count++] = get_line_hash(window, lines[i]);
+    }
 
-    tprint("%s\n", l);
+    return count;
 }
 
-int main(int argc, char **argv) {
-    String    origin_file = {};
-    String    compare_file = {};
+// memory bounds the windows and the line state of both files, different is set when they differ
+b32 diff_streams(Options *options, char *origin_path, char *compare_path, u32 threads, Output *output, b32 *different) {
+    Allocator alloc = get_stdlib_allocator();
+
+    Stream_Side origin  = {};
+    Stream_Side compare = {};
+
+    *different = false;
+
+    if (!platform_stream_open(STR(origin_path), &origin.input)) {
+        return false;
+    }
+
+    if (!platform_stream_open(STR(compare_path), &compare.input)) {
+        platform_stream_close(&origin.input);
+        return false;
+    }
+
+    Stream_Side *sides[] = { &origin, &compare };
+
+    for (u32 i = 0; i < 2; i++) {
+        sides[i]->capacity  = options->memory / 8;
+        sides[i]->max_lines = options->memory / 4 / STREAM_LINE_COST;
+        sides[i]->buffer    = (u8 *)mem_alloc_uninit(alloc, sides[i]->capacity);
+    }
+
+    b32 result = origin.buffer && compare.buffer;
+    b32 header = false;
+
+    if (!result) ERRLOG("Couldn't allocate the stream windows.\n");
+
+    u64 min_run = MAX(2 * options->context + 1, (u64)STREAM_MIN_ANCHOR);
+
+    while (result) {
+        String origin_window  = {};
+        String compare_window = {};
+
+        if (!stream_window(&origin, origin_path, &origin_window) || !stream_window(&compare, compare_path, &compare_window)) {
+            result = false;
+            break;
+        }
+
+        // both files are read to the end and all of their lines fit in the windows
+        b32 last = origin.input.eof && compare.input.eof && origin_window.size == origin.size && compare_window.size == compare.size;
+
+        Hashed_Lines origin_scan  = scan_and_hash_lines(origin_window, threads);
+        Hashed_Lines compare_scan = scan_and_hash_lines(compare_window, threads);
+
+        u64 origin_cut  = origin_scan.lines.count;
+        u64 compare_cut = compare_scan.lines.count;
+
+        u64 mark = temp_mark();
+        Subseq *begin = NULL;
+
+        // set when only the matching prefix goes this round, there's nothing to print then
+        b32 resync = false;
+
+        if (!last && (origin.pending || compare.pending)) {
+            origin_cut  = MIN(origin.pending,  origin_cut);
+            compare_cut = MIN(compare.pending, compare_cut);
+
+            // the file ended early, it changed while it was read
+            if (origin_cut == 0 && compare_cut == 0) {
+                origin_cut  = origin_scan.lines.count;
+                compare_cut = compare_scan.lines.count;
+            }
 
-    List<Line> origin_lines;
-    List<Line> compare_lines;
-    List<meow_u128> origin;
-    List<meow_u128> compare;
+            origin.pending  = origin.pending  > origin_cut  ? origin.pending  - origin_cut  : 0;
+            compare.pending = compare.pending > compare_cut ? compare.pending - compare_cut : 0;
 
-    if (argc == 3) {
-        if (!platform_read_file_into_string(STR(argv[1]), get_stdlib_allocator(), &origin_file)) {
-            return 2;
+            list_delete(&origin_scan.hashes);
+            list_delete(&compare_scan.hashes);
+        } else {
+            // the windows start with the context left by the last cut
+            u64 prefix  = 0;
+            u64 shorter = MIN(origin_cut, compare_cut);
+
+            while (prefix < shorter && hash_equal(origin_scan.hashes[prefix], compare_scan.hashes[prefix])) prefix++;
+
+            // a window that mostly matches holds a cluster of small changes, its own diff is the best
+            // there is. windows that lie within one big change are searched ahead instead, those that
+            // can't match much aren't even diffed, myers is at its slowest on them.
+            u64 min_common = last ? 0 : shorter / 4;
+
+            if (!diff_hashes(options, &origin_scan.hashes, &compare_scan.hashes, get_temporary_allocator(), &begin, min_common)) {
+                list_delete(&origin_scan.lines);
+                list_delete(&compare_scan.lines);
+                result = false;
+                break;
+            }
+
+            u64 matches = 0;
+            for (Subseq *temp = begin; temp; temp = temp->next) matches++;
+
+            if (!last && !stream_find_cut(begin, min_run, options->context, &origin_cut, &compare_cut) && matches < min_common) {
+                Hash128 origin_head[STREAM_MIN_ANCHOR];
+                Hash128 compare_head[STREAM_MIN_ANCHOR];
+
+                u64 origin_heads  = stream_hash_head(origin_window,  origin_scan.lines,  prefix, origin_head);
+                u64 compare_heads = stream_hash_head(compare_window, compare_scan.lines, prefix, compare_head);
+
+                u64 inserted = 0;
+                u64 deleted  = 0;
+
+                b32 insertion = stream_find_run(&compare, origin_head, origin_heads, ~0ull, &inserted) && inserted > prefix;
+                b32 deletion  = stream_find_run(&origin, compare_head, compare_heads, insertion ? inserted : ~0ull, &deleted) && deleted > prefix;
+
+                if (deletion && (!insertion || deleted < inserted)) {
+                    origin.pending = deleted - prefix;
+                } else if (insertion) {
+                    compare.pending = inserted - prefix;
+                }
+
+                // the matching prefix goes now, the change is printed by the next round without diffing
+                if (origin.pending || compare.pending) {
+                    origin_cut  = prefix;
+                    compare_cut = prefix;
+                    resync      = true;
+                }
+            }
+        }
+
+        // matches behind the cut are diffed again with the next window
+        for (Subseq **link = &begin; *link; link = &(*link)->next) {
+            if ((*link)->origin_index >= origin_cut) {
+                *link = NULL;
+                break;
+            }
         }
-        if (!platform_read_file_into_string(STR(argv[2]), get_stdlib_allocator(), &compare_file)) {
-            return 2;
+
+        Diff_Side origin_side  = { origin_path,  origin_window,  origin_scan.lines,  origin.line_base };
+        Diff_Side compare_side = { compare_path, compare_window, compare_scan.lines, compare.line_base };
+
+        origin_side.lines.count  = origin_cut;
+        compare_side.lines.count = compare_cut;
+
+        origin_side.partial  = !last;
+        compare_side.partial = !last;
+
+        if (!resync) {
+            print_unified(output, &origin_side, &compare_side, begin, options->context, &header);
+            output_flush(output);
         }
 
-        origin_lines  = scan_lines(origin_file);
-        compare_lines = scan_lines(compare_file);
-        origin  = get_hashed_lines(origin_file, origin_lines);
-        compare = get_hashed_lines(compare_file, compare_lines);
+        temp_restore(mark);
+
+        stream_advance(&origin,  origin_scan.lines,  origin_cut);
+        stream_advance(&compare, compare_scan.lines, compare_cut);
+
+        list_delete(&origin_scan.lines);
+        list_delete(&compare_scan.lines);
 
+        if (last) break;
+    }
+
+    *different = header;
+
+    mem_free(alloc, origin.buffer);
+    mem_free(alloc, compare.buffer);
+    platform_stream_close(&origin.input);
+    platform_stream_close(&compare.input);
+
+    return result;
+}
+
+/// Diffing two files
+
+// diffs the scanned sides and prints the result, the sides get the lines of their scans
+b32 diff_sides(Options *options, Diff_Side *origin, Diff_Side *compare, Hashed_Lines origin_scan, Hashed_Lines compare_scan, Output *output) {
+    origin->lines  = origin_scan.lines;
+    compare->lines = compare_scan.lines;
+
+    u64 mark = temp_mark();
+    Subseq *begin = NULL;
+
+    if (!diff_hashes(options, &origin_scan.hashes, &compare_scan.hashes, get_temporary_allocator(), &begin)) {
+        return false;
+    }
+
+    if (options->unified) {
+        print_unified(output, origin, compare, begin, options->context);
     } else {
-        ERRLOG("please call with 2 args.\n    %s [old] [new]", argv[0]);
-        return 1;
+        print_full(output, origin, compare, begin);
     }
 
-    Subseq *begin = get_subsequence(origin, compare, get_temporary_allocator());
+    temp_restore(mark);
 
-    { // print origin file
-        Subseq *temp = begin;
-        tprint("> %s\n", STR(argv[1]));
-        for (u64 i = 0; i < origin_lines.count; i++) {
-            if (temp && temp->origin_index != i) {
-                tprint("- ");
-                print_line(origin_file, origin_lines[i]);
-            } else if (temp) {
-                tprint("  ");
-                print_line(origin_file, origin_lines[i]);
-                temp = temp->next;
-            } else {
-                tprint("- ");
-                print_line(origin_file, origin_lines[i]);
+    return true;
+}
+
+// settles a pair from file metadata without reading it: the same file twice (hard links,
+// `chiff a a`) and, with --trust-mtime, the same size and modification time.
+// different sizes are left to files_are_identical, which rejects them before hashing.
+// pipes have no size or time worth trusting and never match.
+b32 files_match_by_info(Options *options, File_Info *origin, File_Info *compare) {
+    if (!origin->regular || !compare->regular) return false;
+    if (origin->size != compare->size) return false;
+
+    // some filesystems report no file ids at all
+    if (origin->inode != 0 && origin->device == compare->device && origin->inode == compare->inode) return true;
+
+    return options->trust_mtime && origin->modified == compare->modified;
+}
+
+// one file of a pair. stdin and pipes are scanned and hashed chunk by chunk while
+// they are read, everything else is scanned once it's open.
+struct Diff_Input {
+    char      *path;
+    File_Info  info;
+    Input_File file;
+
+    b32 stream;
+    b32 opened;
+    Incremental_Scan scan;
+};
+
+static void diff_input_stat(Diff_Input *input) {
+    String path = STR(input->path);
+
+    // files that can't be looked at aren't streams, opening them reports the error
+    input->stream = platform_is_stdin(path) || (platform_file_info(path, &input->info) && !input->info.regular);
+}
+
+static b32 diff_input_open(Diff_Input *input) {
+    String path = STR(input->path);
+
+    if (!input->stream) return platform_open_input(path, &input->file);
+    if (!incremental_scan_create(&input->scan)) return false;
+    if (!platform_read_stream(path, &input->file.data, incremental_scan_proc, &input->scan)) return false;
+
+    incremental_scan_finish(&input->scan, input->file.data);
+    return true;
+}
+
+static void diff_input_proc(void *data) {
+    Diff_Input *input = (Diff_Input *)data;
+    input->opened = diff_input_open(input);
+    temp_release();
+}
+
+// hands over the lines of the input, streams already have theirs
+static Hashed_Lines diff_input_lines(Diff_Input *input, u32 threads) {
+    if (!input->stream) return scan_and_hash_lines(input->file.data, threads);
+
+    Hashed_Lines result = input->scan.result;
+    input->scan.result = {};
+    return result;
+}
+
+static void diff_input_close(Diff_Input *input) {
+    if (input->scan.result.lines.data)  list_delete(&input->scan.result.lines);
+    if (input->scan.result.hashes.data) list_delete(&input->scan.result.hashes);
+    platform_close_input(&input->file);
+}
+
+// identical files print nothing, different is set when they aren't
+b32 diff_files(Options *options, char *origin_path, char *compare_path, u32 threads, Output *output, b32 *different) {
+    Diff_Input origin  = {};
+    Diff_Input compare = {};
+
+    origin.path  = origin_path;
+    compare.path = compare_path;
+
+    *different = false;
+
+    diff_input_stat(&origin);
+    diff_input_stat(&compare);
+
+    if (files_match_by_info(options, &origin.info, &compare.info)) return true;
+
+    if (options->memory) {
+        return diff_streams(options, origin_path, compare_path, threads, output, different);
+    }
+
+    // a producer whose pipe isn't read blocks, so two of them are read side by side
+    Thread reader = {};
+    b32 concurrent = origin.stream && compare.stream && platform_thread_start(&reader, diff_input_proc, &compare);
+
+    origin.opened = diff_input_open(&origin);
+
+    if (concurrent) {
+        platform_thread_join(&reader);
+    } else if (origin.opened) {
+        compare.opened = diff_input_open(&compare);
+    }
+
+    b32 result = origin.opened && compare.opened;
+
+    if (result && !files_are_identical(origin.file.data, compare.file.data)) {
+        *different = true;
+
+        Diff_Side origin_side  = { origin_path,  origin.file.data,  {} };
+        Diff_Side compare_side = { compare_path, compare.file.data, {} };
+
+        Hashed_Lines origin_scan  = diff_input_lines(&origin,  threads);
+        Hashed_Lines compare_scan = diff_input_lines(&compare, threads);
+
+        result = diff_sides(options, &origin_side, &compare_side, origin_scan, compare_scan, output);
+
+        if (origin_side.lines.data)  list_delete(&origin_side.lines);
+        if (compare_side.lines.data) list_delete(&compare_side.lines);
+    }
+
+    diff_input_close(&origin);
+    diff_input_close(&compare);
+
+    return result;
+}
+
+#ifdef DEBUG
+// applies a unified diff to origin the way patch does, into buffer
+static String unified_apply(String origin, String diff, u8 *buffer) {
+    Hashed_Lines lines = scan_and_hash_lines(origin);
+    u64 size = 0;
+    u64 at   = 0;
+    u8  last = 0;
+    b32 hunk = false;
+
+    for (u64 start = 0, stop = 0; start < diff.size; start = stop + 1) {
+        stop = start;
+        while (stop < diff.size && diff.data[stop] != '\n') stop++;
+
+        u8 *text = diff.data + start;
+
+        if (text[0] == '@') {
+            hunk = true;
+
+            char *end = NULL;
+            u64 line  = strtoull((char *)text + 4, &end, 10);
+            u64 count = strtoull(end + 1, NULL, 10);
+
+            // empty ranges point at the line before them
+            for (u64 skip = count == 0 ? line : line - 1; at < skip; at++) {
+                Line copy = lines.lines[at];
+                u64 copy_stop = MIN(copy.stop + 1, origin.size);
+
+                mem_copy(buffer + size, origin.data + copy.start, copy_stop - copy.start);
+                size += copy_stop - copy.start;
+            }
+        } else if (!hunk) {
+            // the --- and +++ header
+        } else if (text[0] == ' ' || text[0] == '-') {
+            Line line = lines.lines[at++];
+            assert(stop - start - 1 == line.stop - line.start);
+            assert(!mem_compare(text + 1, origin.data + line.start, line.stop - line.start));
+
+            if (text[0] == ' ') {
+                u64 line_stop = MIN(line.stop + 1, origin.size);
+                mem_copy(buffer + size, origin.data + line.start, line_stop - line.start);
+                size += line_stop - line.start;
             }
+        } else if (text[0] == '+') {
+            mem_copy(buffer + size, text + 1, stop - start - 1);
+            size += stop - start - 1;
+            buffer[size++] = '\n';
+        } else if (text[0] == '\\') {
+            // context and removed lines come from origin and already have no newline
+            if (last == '+') size--;
         }
+
+        last = text[0];
     }
 
-    tprint("\n");
+    for (; at < lines.lines.count; at++) {
+        Line copy = lines.lines[at];
+        u64 copy_stop = MIN(copy.stop + 1, origin.size);
 
-    { // print compared file
-        Subseq *temp = begin;
-        tprint("> %s\n", STR(argv[2]));
-        for (u64 i = 0; i < compare_lines.count; i++) {
-            if (temp && temp->compare_index != i) {
-                tprint("+ ");
-                print_line(compare_file, compare_lines[i]);
-            } else if (temp) {
-                tprint("  ");
-                print_line(compare_file, compare_lines[i]);
-                temp = temp->next;
-            } else {
-                tprint("+ ");
-                print_line(compare_file, compare_lines[i]);
+        mem_copy(buffer + size, origin.data + copy.start, copy_stop - copy.start);
+        size += copy_stop - copy.start;
+    }
+
+    list_delete(&lines.lines);
+    list_delete(&lines.hashes);
+
+    return { size, buffer };
+}
+#endif
+
+// unified diffs have to patch the origin into the compare file, also when either misses the last newline
+void unified_tests(void) {
+#ifdef DEBUG
+    String cases[][2] = {
+        { STR("a\nb"),       STR("a\nb\n") },
+        { STR("a\nb\n"),     STR("a\nb") },
+        { STR("a\nb"),       STR("a\nc") },
+        { STR("x\na\nb"),    STR("y\na\nb") },
+        { STR(""),           STR("a") },
+        { STR("a"),          STR("") },
+        { STR("a\n\nb\n"),   STR("a\n\nc") },
+        { STR("a\nb\nc\nd\ne\nf\ng\nh"), STR("a\nB\nc\nd\ne\nf\ng\nh") },
+        { STR("a\nb\nc\nd\ne\nf\ng\nh"), STR("a\nb\nc\nd\ne\nf\ng\nh\n") },
+    };
+
+    u64 contexts[] = { 0, 1, 3 };
+
+    for (u64 i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        for (u64 j = 0; j < sizeof(contexts) / sizeof(contexts[0]); j++) {
+            Options options = {};
+            options.unified = true;
+            options.context = contexts[j];
+
+            Output output = {};
+            assert(output_create(&output, KB(4)));
+            output.buffered = true;
+
+            Diff_Side origin  = { (char *)"a", cases[i][0], {} };
+            Diff_Side compare = { (char *)"b", cases[i][1], {} };
+
+            assert(diff_sides(&options, &origin, &compare, scan_and_hash_lines(origin.file), scan_and_hash_lines(compare.file), &output));
+
+            u8 buffer[256];
+            String patched = unified_apply(origin.file, { output.size, output.data }, buffer);
+            assert(!string_compare(patched, compare.file));
+
+            if (origin.lines.data)  list_delete(&origin.lines);
+            if (compare.lines.data) list_delete(&compare.lines);
+            output_delete(&output);
+        }
+    }
+#endif
+}
+
+/// Directory mode
+//
+// every file pair is a job. workers pull the next job from a shared counter and print it
+// into the job's own buffered output. the main thread runs jobs too, and in between writes
+// the finished outputs to stdout in path order, so the result doesn't depend on scheduling.
+
+struct Tree_Job {
+    Tree_Pair pair;
+    Output    output;
+
+    b32 different;
+    b32 failed;
+    u32 done;
+};
+
+struct Tree_Queue {
+    Options *options;
+    String   origin_root;
+    String   compare_root;
+
+    Tree_Job *jobs;
+    u64       count;
+    u64       next;
+
+    // only touched by the main thread
+    u64 printed;
+    b32 different;
+    b32 failed;
+};
+
+static char *tree_join(String root, String path) {
+    String joined = string_concat(root, string_concat(STR("/"), path, get_temporary_allocator()), get_temporary_allocator());
+    return string_to_c_string(joined, get_temporary_allocator());
+}
+
+static void tree_run_job(Tree_Queue *queue, Tree_Job *job) {
+    Tree_Pair pair = job->pair;
+
+    if (!output_create(&job->output, KB(16))) {
+        job->failed = true;
+    } else {
+        job->output.buffered = true;
+
+        if (pair.in_origin && pair.in_compare) {
+            char *origin_path  = tree_join(queue->origin_root,  pair.source.data ? pair.source : pair.path);
+            char *compare_path = tree_join(queue->compare_root, pair.path);
+
+            if (pair.source.data) {
+                output_write(&job->output, pair.copy ? STR("copy from ") : STR("rename from "));
+                output_write(&job->output, STR(origin_path));
+                output_write(&job->output, STR(" to "));
+                output_write(&job->output, STR(compare_path));
+                output_write(&job->output, STR(" (similarity "));
+                output_write(&job->output, (u64)pair.similarity);
+                output_write(&job->output, STR("%)\n"));
             }
+
+            job->failed = !diff_files(queue->options, origin_path, compare_path, 1, &job->output, &job->different);
+            if (pair.source.data) job->different = true;
+        } else {
+            output_write(&job->output, STR("only in "));
+            output_write(&job->output, pair.in_origin ? queue->origin_root : queue->compare_root);
+            output_write(&job->output, STR(": "));
+            output_write(&job->output, pair.path);
+            output_write(&job->output, (u8)'\n');
+
+            job->different = true;
         }
     }
 
-    return 0;
+    temp_reset();
+    platform_atomic_store(&job->done, true);
+}
+
+static b32 tree_take_job(Tree_Queue *queue, Tree_Job **job) {
+    u64 index = platform_atomic_add(&queue->next, 1);
+    if (index >= queue->count) return false;
+
+    *job = queue->jobs + index;
+    return true;
+}
+
+static void tree_worker_proc(void *data) {
+    Tree_Queue *queue = (Tree_Queue *)data;
+
+    for (Tree_Job *job; tree_take_job(queue, &job);) {
+        tree_run_job(queue, job);
+    }
+
+    temp_release();
+}
+
+// writes every finished job that isn't waiting on an earlier one
+static void tree_print_ready(Tree_Queue *queue, Output *output) {
+    for (; queue->printed < queue->count; queue->printed++) {
+        Tree_Job *job = queue->jobs + queue->printed;
+        if (!platform_atomic_load(&job->done)) break;
+
+        output_write(output, { job->output.size, job->output.data });
+        if (job->output.data) output_delete(&job->output);
+
+        queue->different |= job->different;
+        queue->failed    |= job->failed;
+    }
+}
+
+static String tree_trim_root(char *path) {
+    String root = STR(path);
+    while (root.size > 1 && (root.data[root.size - 1] == '/' || root.data[root.size - 1] == '\\')) root.size--;
+    return root;
+}
+
+int diff_trees(Options *options) {
+    Tree_Queue queue = {};
+    queue.options      = options;
+    queue.origin_root  = tree_trim_root(options->origin_path);
+    queue.compare_root = tree_trim_root(options->compare_path);
+
+    List<String> origin_files  = tree_list_files(queue.origin_root);
+    List<String> compare_files = tree_list_files(queue.compare_root);
+    List<Tree_Pair> pairs = tree_pair_files(origin_files, compare_files);
+
+    if (origin_files.data)  list_delete(&origin_files);
+    if (compare_files.data) list_delete(&compare_files);
+
+    tree_detect_renames(&pairs, queue.origin_root, queue.compare_root, options->rename_similarity, options->copy_similarity, options->threads);
+
+    queue.count = pairs.count;
+    queue.jobs  = (Tree_Job *)mem_alloc(get_stdlib_allocator(), (pairs.count + 1) * sizeof(Tree_Job));
+
+    for (u64 i = 0; i < pairs.count; i++) {
+        queue.jobs[i].pair = pairs[i];
+    }
+
+    u32 threads = options->threads;
+    if (threads < 1) threads = 1;
+    if (threads > pairs.count) threads = (u32)pairs.count;
+
+    // before any worker runs, so failing here leaves no threads behind
+    Output output = {};
+
+    if (!output_create(&output)) {
+        mem_free(get_stdlib_allocator(), queue.jobs);
+        tree_delete_pairs(&pairs);
+        return 2;
+    }
+
+    Thread *workers = NULL;
+    if (threads > 1) workers = (Thread *)mem_alloc(get_stdlib_allocator(), threads * sizeof(Thread));
+
+    // the main thread is worker 0
+    for (u32 i = 1; i < threads; i++) {
+        if (!platform_thread_start(&workers[i], tree_worker_proc, &queue)) workers[i].proc = NULL;
+    }
+
+    for (Tree_Job *job; tree_take_job(&queue, &job);) {
+        tree_run_job(&queue, job);
+        tree_print_ready(&queue, &output);
+    }
+
+    while (queue.printed < queue.count) {
+        tree_print_ready(&queue, &output);
+        if (queue.printed < queue.count) platform_yield();
+    }
+
+    for (u32 i = 1; i < threads; i++) {
+        if (workers[i].proc) platform_thread_join(&workers[i]);
+    }
+
+    if (!queue.different && !queue.failed) {
+        output_write(&output, STR("no differences\n"));
+    }
+
+    output_delete(&output);
+
+    if (workers) mem_free(get_stdlib_allocator(), workers);
+    mem_free(get_stdlib_allocator(), queue.jobs);
+    tree_delete_pairs(&pairs);
+
+    return queue.failed ? 2 : 0;
+}
+
+// the benchmark includes this file for the printers and brings its own main
+#ifndef CHIFF_NO_MAIN
+int main(int argc, char **argv) {
+    hash_init();
+
+#ifdef DEBUG
+    // debug builds check themselves on every run, the tests are small
+    string_tests();
+    unified_tests();
+#endif
+
+    Options options = {};
+    options.threads = platform_cpu_count();
+    options.context = 3;
+
+    if (!parse_options(argc, argv, &options)) {
+        ERRLOG("please call with 2 args.\n    %s [--myers | --patience | --histogram] [-u | -U context] [-j threads] [--trust-mtime] [-M[n] | -C[n]] [--memory size] [old | -] [new | -]", argv[0]);
+        return 1;
+    }
+
+    if (platform_is_stdin(STR(options.origin_path)) && platform_is_stdin(STR(options.compare_path))) {
+        ERRLOG("stdin can only be one of the files.\n");
+        return 2;
+    }
+
+    // the myers trace is part of the budget
+    if (options.memory) myers_trace_limit = options.memory / 4;
+
+    b32 origin_directory  = platform_is_directory(STR(options.origin_path));
+    b32 compare_directory = platform_is_directory(STR(options.compare_path));
+
+    if (origin_directory && compare_directory) {
+        return diff_trees(&options);
+    }
+
+    if (origin_directory || compare_directory) {
+        ERRLOG("can't compare a directory with a file.\n");
+        return 2;
+    }
+
+    Output output = {};
+    if (!output_create(&output)) return 2;
+
+    b32 different = false;
+    b32 result = diff_files(&options, options.origin_path, options.compare_path, options.threads, &output, &different);
+
+    if (result && !different) {
+        output_write(&output, STR("no differences\n"));
+    }
+
+    output_delete(&output);
+
+    return result ? 0 : 2;
 }
+#endif // CHIFF_NO_MAIN
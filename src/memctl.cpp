@@ -1,10 +1,189 @@
+#include <immintrin.h>
+
+// copies and sets bigger than this bypass the cache with streaming stores
+#define MEM_STREAM_THRESHOLD MB(8)
+
+// sizes below one vector stay on the byte loops
+#define MEM_SMALL_SIZE 32
+
+/// Portable fallback
+
+static void mem_set_scalar(u8 *buffer, u8 value, u64 size) {
+    while (size-- > 0) {
+        *buffer++ = value;
+    }
+}
+
+static void mem_copy_scalar(u8 *dest, u8 *source, u64 size) {
+    while (size-- > 0) {
+        *dest++ = *source++;
+    }
+}
+
+static s32 mem_compare_scalar(u8 *left, u8 *right, u64 size) {
+    while (size-- > 0) {
+        if (*left++ == *right++)
+            continue;
+
+        return left[-1] > right[-1] ? 1 : -1;
+    }
+
+    return 0;
+}
+
+/// SSE2 and AVX2 kernels
+//
+// head is one unaligned vector, the body runs on aligned destination addresses and
+// the tail is the last unaligned vector, overlapping whatever the body already wrote.
+
+static void mem_set_sse2(u8 *buffer, u8 value, u64 size) {
+    __m128i fill = _mm_set1_epi8((char)value);
+
+    u8 *end = buffer + size;
+    _mm_storeu_si128((__m128i *)buffer, fill);
+
+    u8 *at = (u8 *)(((uintptr_t)buffer + 16) & ~(uintptr_t)15);
+
+    if (size >= MEM_STREAM_THRESHOLD) {
+        for (; at + 16 <= end; at += 16) _mm_stream_si128((__m128i *)at, fill);
+        _mm_sfence();
+    } else {
+        for (; at + 16 <= end; at += 16) _mm_store_si128((__m128i *)at, fill);
+    }
+
+    _mm_storeu_si128((__m128i *)(end - 16), fill);
+}
+
+static void mem_copy_sse2(u8 *dest, u8 *source, u64 size) {
+    u8 *end = dest + size;
+    __m128i tail = _mm_loadu_si128((__m128i *)(source + size - 16));
+
+    _mm_storeu_si128((__m128i *)dest, _mm_loadu_si128((__m128i *)source));
+
+    u8 *at = (u8 *)(((uintptr_t)dest + 16) & ~(uintptr_t)15);
+    source += at - dest;
+
+    if (size >= MEM_STREAM_THRESHOLD) {
+        for (; at + 16 <= end; at += 16, source += 16) _mm_stream_si128((__m128i *)at, _mm_loadu_si128((__m128i *)source));
+        _mm_sfence();
+    } else {
+        for (; at + 16 <= end; at += 16, source += 16) _mm_store_si128((__m128i *)at, _mm_loadu_si128((__m128i *)source));
+    }
+
+    _mm_storeu_si128((__m128i *)(end - 16), tail);
+}
+
+static s32 mem_compare_sse2(u8 *left, u8 *right, u64 size) {
+    u64 i = 0;
+
+    for (;; i += 16) {
+        // last step re-checks the final 16 bytes
+        if (i + 16 > size) i = size - 16;
+
+        __m128i a = _mm_loadu_si128((__m128i *)(left  + i));
+        __m128i b = _mm_loadu_si128((__m128i *)(right + i));
+        u32 mask  = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(a, b));
+
+        if (mask != 0xFFFF) {
+            u64 at = i + __builtin_ctz(~mask & 0xFFFF);
+            return left[at] > right[at] ? 1 : -1;
+        }
+
+        if (i + 16 == size) return 0;
+    }
+}
+
+TARGET_AVX2 static void mem_set_avx2(u8 *buffer, u8 value, u64 size) {
+    __m256i fill = _mm256_set1_epi8((char)value);
+
+    u8 *end = buffer + size;
+    _mm256_storeu_si256((__m256i *)buffer, fill);
+
+    u8 *at = (u8 *)(((uintptr_t)buffer + 32) & ~(uintptr_t)31);
+
+    if (size >= MEM_STREAM_THRESHOLD) {
+        for (; at + 32 <= end; at += 32) _mm256_stream_si256((__m256i *)at, fill);
+        _mm_sfence();
+    } else {
+        for (; at + 32 <= end; at += 32) _mm256_store_si256((__m256i *)at, fill);
+    }
+
+    _mm256_storeu_si256((__m256i *)(end - 32), fill);
+}
+
+TARGET_AVX2 static void mem_copy_avx2(u8 *dest, u8 *source, u64 size) {
+    u8 *end = dest + size;
+    __m256i tail = _mm256_loadu_si256((__m256i *)(source + size - 32));
+
+    _mm256_storeu_si256((__m256i *)dest, _mm256_loadu_si256((__m256i *)source));
+
+    u8 *at = (u8 *)(((uintptr_t)dest + 32) & ~(uintptr_t)31);
+    source += at - dest;
+
+    if (size >= MEM_STREAM_THRESHOLD) {
+        for (; at + 32 <= end; at += 32, source += 32) _mm256_stream_si256((__m256i *)at, _mm256_loadu_si256((__m256i *)source));
+        _mm_sfence();
+    } else {
+        for (; at + 32 <= end; at += 32, source += 32) _mm256_store_si256((__m256i *)at, _mm256_loadu_si256((__m256i *)source));
+    }
+
+    _mm256_storeu_si256((__m256i *)(end - 32), tail);
+}
+
+TARGET_AVX2 static s32 mem_compare_avx2(u8 *left, u8 *right, u64 size) {
+    u64 i = 0;
+
+    for (;; i += 32) {
+        // last step re-checks the final 32 bytes
+        if (i + 32 > size) i = size - 32;
+
+        __m256i a = _mm256_loadu_si256((__m256i *)(left  + i));
+        __m256i b = _mm256_loadu_si256((__m256i *)(right + i));
+        u32 mask  = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b));
+
+        if (mask != 0xFFFFFFFF) {
+            u64 at = i + __builtin_ctz(~mask);
+            return left[at] > right[at] ? 1 : -1;
+        }
+
+        if (i + 32 == size) return 0;
+    }
+}
+
+/// Dispatch
+//
+// kernels are picked once, on the first call of each function. the picks are function
+// statics, which are initialized once even when several threads make the first call.
+
+typedef void Mem_Set_Proc(u8 *buffer, u8 value, u64 size);
+typedef void Mem_Copy_Proc(u8 *dest, u8 *source, u64 size);
+typedef s32  Mem_Compare_Proc(u8 *left, u8 *right, u64 size);
+
+static Mem_Set_Proc *mem_set_kernel(void) {
+    static Mem_Set_Proc *kernel = cpu_features().avx2 ? mem_set_avx2 : cpu_features().sse2 ? mem_set_sse2 : mem_set_scalar;
+    return kernel;
+}
+
+static Mem_Copy_Proc *mem_copy_kernel(void) {
+    static Mem_Copy_Proc *kernel = cpu_features().avx2 ? mem_copy_avx2 : cpu_features().sse2 ? mem_copy_sse2 : mem_copy_scalar;
+    return kernel;
+}
+
+static Mem_Compare_Proc *mem_compare_kernel(void) {
+    static Mem_Compare_Proc *kernel = cpu_features().avx2 ? mem_compare_avx2 : cpu_features().sse2 ? mem_compare_sse2 : mem_compare_scalar;
+    return kernel;
+}
+
 void mem_set(u8 *buffer, u8 value, u64 size) {
     if (size == 0) return;
     assert(buffer != NULL);
 
-    while (size-- > 0) {
-        *buffer++ = value;
+    if (size < MEM_SMALL_SIZE) {
+        mem_set_scalar(buffer, value, size);
+        return;
     }
+
+    mem_set_kernel()(buffer, value, size);
 }
 
 void mem_copy(u8 *dest, u8 *source, u64 size) {
@@ -21,19 +200,18 @@ void mem_copy(u8 *dest, u8 *source, u64 size) {
     }
 #endif // DEBUG
 
-    while (size-- > 0) {
-        *dest++ = *source++;
+    if (size < MEM_SMALL_SIZE) {
+        mem_copy_scalar(dest, source, size);
+        return;
     }
+
+    mem_copy_kernel()(dest, source, size);
 }
 
 s32 mem_compare(u8 *left, u8 *right, u64 size) {
-    while (size-- > 0) {
-        if (*left++ == *right++)
-            continue;
-
-        return left[-1] > right[-1] ? 1 : -1;
+    if (size < MEM_SMALL_SIZE) {
+        return mem_compare_scalar(left, right, size);
     }
 
-    return 0;
+    return mem_compare_kernel()(left, right, size);
 }
-
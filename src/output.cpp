@@ -0,0 +1,110 @@
+/// Output buffer
+//
+// printing copies line slices straight from the input into one big buffer,
+// which goes to stdout in a single write when it fills up. discarding outputs
+// do all the formatting and drop the bytes, the benchmark prints into those.
+// buffered outputs grow instead and keep everything until the owner writes it out,
+// directory mode prints every file into one so the order stays deterministic.
+
+#define OUTPUT_BUFFER_SIZE MB(4)
+
+struct Output {
+    u8 *data;
+    u64 size;
+    u64 capacity;
+
+    b32 discard;
+    b32 buffered;
+};
+
+b32 output_create(Output *output, u64 capacity = OUTPUT_BUFFER_SIZE) {
+    *output = {};
+    output->data     = (u8 *)mem_alloc_uninit(get_stdlib_allocator(), capacity);
+    output->capacity = capacity;
+
+    if (!output->data) {
+        ERRLOG("Output: Couldn't create buffer.");
+        return false;
+    }
+
+    return true;
+}
+
+static void output_emit(Output *output, String *parts, u32 count) {
+    if (output->discard) return;
+    platform_write_stdout(parts, count);
+}
+
+static b32 output_grow(Output *output, u64 size) {
+    u64 capacity = output->capacity;
+    while (capacity < size) capacity *= 2;
+
+    u8 *data = (u8 *)mem_realloc(get_stdlib_allocator(), output->data, capacity);
+
+    if (!data) {
+        ERRLOG("Output: Couldn't grow buffer.");
+        return false;
+    }
+
+    output->data     = data;
+    output->capacity = capacity;
+    return true;
+}
+
+void output_flush(Output *output) {
+    if (output->size == 0 || output->buffered) return;
+
+    String buffered = { output->size, output->data };
+    output_emit(output, &buffered, 1);
+    output->size = 0;
+}
+
+// buffered outputs are dropped, the owner writes them out before
+void output_delete(Output *output) {
+    output_flush(output);
+    mem_free(get_stdlib_allocator(), output->data);
+    *output = {};
+}
+
+void output_write(Output *output, String text) {
+    if (output->size + text.size > output->capacity) {
+        if (output->buffered) {
+            if (!output_grow(output, output->size + text.size)) return;
+        } else if (text.size >= output->capacity) {
+            // too big to buffer, goes out together with what is buffered
+            String parts[] = { { output->size, output->data }, text };
+            output_emit(output, parts, 2);
+            output->size = 0;
+            return;
+        } else {
+            output_flush(output);
+        }
+    }
+
+    mem_copy(output->data + output->size, text.data, text.size);
+    output->size += text.size;
+}
+
+void output_write(Output *output, u8 byte) {
+    if (output->size == output->capacity) {
+        if (output->buffered) {
+            if (!output_grow(output, output->size + 1)) return;
+        } else {
+            output_flush(output);
+        }
+    }
+
+    output->data[output->size++] = byte;
+}
+
+void output_write(Output *output, u64 value) {
+    u8  digits[20];
+    u64 count = 0;
+
+    do {
+        digits[sizeof(digits) - ++count] = (u8)('0' + value % 10);
+        value /= 10;
+    } while (value);
+
+    output_write(output, { count, digits + sizeof(digits) - count });
+}
@@ -0,0 +1,674 @@
+b32 platform_write_file(String filename, String data) {
+    assert(filename.data != NULL);
+    assert(filename.size > 0);
+
+    FILE *file = fopen(string_to_c_string(filename, get_temporary_allocator()), "wb");
+
+    if (file == NULL) {
+        ERRLOG("Could not create file. %.*s", (int)filename.size, filename.data);
+        return false;
+    }
+
+    u64 bytes_written = fwrite(data.data, sizeof(u8), data.size, file);
+    fclose(file);
+
+    if (bytes_written < data.size) {
+        ERRLOG("Could not write file. %.*s", (int)filename.size, filename.data);
+        return false;
+    }
+
+    return true;
+}
+
+// existing directories count as success
+b32 platform_make_directory(String path) {
+    char *c_path = string_to_c_string(path, get_temporary_allocator());
+
+#ifdef _WIN32
+    if (CreateDirectoryA(c_path, NULL) || GetLastError() == ERROR_ALREADY_EXISTS) return true;
+#else
+    if (mkdir(c_path, 0755) == 0 || errno == EEXIST) return true;
+#endif
+
+    ERRLOG("Could not create directory. %.*s", (int)path.size, path.data);
+    return false;
+}
+
+/// File info
+
+struct File_Info {
+    u64 size;
+    u64 modified; // ns since the epoch on linux, 100ns ticks since 1601 on windows
+    u64 device;
+    u64 inode;
+    b32 regular; // pipes, devices and directories aren't
+};
+
+b32 platform_file_info(String path, File_Info *info) {
+    char *c_path = string_to_c_string(path, get_temporary_allocator());
+    *info = {};
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(c_path, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    BY_HANDLE_FILE_INFORMATION data = {};
+    b32 disk   = GetFileType(file) == FILE_TYPE_DISK;
+    b32 result = GetFileInformationByHandle(file, &data);
+    CloseHandle(file);
+
+    // pipes have no file information but they do exist
+    if (!result && disk) return false;
+
+    info->size     = ((u64)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+    info->modified = ((u64)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+    info->device   = data.dwVolumeSerialNumber;
+    info->inode    = ((u64)data.nFileIndexHigh << 32) | data.nFileIndexLow;
+    info->regular  = disk && !(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+    struct stat data = {};
+    if (stat(c_path, &data) != 0) return false;
+
+    info->size     = (u64)data.st_size;
+    info->modified = (u64)data.st_mtim.tv_sec * 1000000000ull + (u64)data.st_mtim.tv_nsec;
+    info->device   = (u64)data.st_dev;
+    info->inode    = (u64)data.st_ino;
+    info->regular  = S_ISREG(data.st_mode);
+#endif
+
+    return true;
+}
+
+/// Directories
+
+struct Directory_Entry {
+    String name;
+    b32    directory;
+};
+
+b32 platform_is_directory(String path) {
+    char *c_path = string_to_c_string(path, get_temporary_allocator());
+
+#ifdef _WIN32
+    DWORD attributes = GetFileAttributesA(c_path);
+    return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+    struct stat info = {};
+    return stat(c_path, &info) == 0 && S_ISDIR(info.st_mode);
+#endif
+}
+
+// adds every file and directory in path to entries, names are allocated with alloc.
+// symlinked directories are skipped so walks can't loop, special files are skipped too.
+b32 platform_list_directory(String path, List<Directory_Entry> *entries, Allocator alloc) {
+#ifdef _WIN32
+    char *pattern = string_to_c_string(string_concat(path, STR("\\*"), get_temporary_allocator()), get_temporary_allocator());
+
+    WIN32_FIND_DATAA data = {};
+    HANDLE find = FindFirstFileA(pattern, &data);
+
+    if (find == INVALID_HANDLE_VALUE) {
+        ERRLOG("Could not open directory. %.*s\n", (int)path.size, path.data);
+        return false;
+    }
+
+    do {
+        String name = STR(data.cFileName);
+
+        if (!string_compare(name, STR(".")) || !string_compare(name, STR(".."))) continue;
+
+        b32 directory = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        if (directory && (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)) continue;
+
+        Directory_Entry entry = { string_copy(name, alloc), directory };
+        list_add(entries, entry);
+    } while (FindNextFileA(find, &data));
+
+    FindClose(find);
+#else
+    DIR *directory = opendir(string_to_c_string(path, get_temporary_allocator()));
+
+    if (directory == NULL) {
+        ERRLOG("Could not open directory. %.*s\n", (int)path.size, path.data);
+        return false;
+    }
+
+    for (struct dirent *item; (item = readdir(directory)) != NULL;) {
+        String name = STR(item->d_name);
+
+        if (!string_compare(name, STR(".")) || !string_compare(name, STR(".."))) continue;
+
+        u8 type = item->d_type;
+
+        if (type == DT_UNKNOWN || type == DT_LNK) {
+            String full = string_concat(path, string_concat(STR("/"), name, get_temporary_allocator()), get_temporary_allocator());
+
+            struct stat info = {};
+            if (stat(string_to_c_string(full, get_temporary_allocator()), &info) != 0) continue;
+
+            if (S_ISREG(info.st_mode)) {
+                type = DT_REG;
+            } else if (S_ISDIR(info.st_mode) && type == DT_UNKNOWN) {
+                type = DT_DIR;
+            } else {
+                continue;
+            }
+        }
+
+        if (type != DT_REG && type != DT_DIR) continue;
+
+        Directory_Entry entry = { string_copy(name, alloc), type == DT_DIR };
+        list_add(entries, entry);
+    }
+
+    closedir(directory);
+#endif
+
+    return true;
+}
+
+/// Input streams
+//
+// sequential reads into a buffer of the caller, for inputs that are read in windows
+// instead of all at once. regular files can also be read ahead at an offset.
+
+// "-" stands for stdin wherever a file is read
+b32 platform_is_stdin(String path) {
+    return path.size == 1 && path.data[0] == '-';
+}
+
+struct Input_Stream {
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    int    file;
+#endif
+    b32 eof;
+    b32 seekable;
+};
+
+b32 platform_stream_open(String filename, Input_Stream *stream) {
+    *stream = {};
+
+    u64 mark = temp_mark();
+    char *path = string_to_c_string(filename, get_temporary_allocator());
+
+#ifdef _WIN32
+    if (platform_is_stdin(filename)) {
+        HANDLE process = GetCurrentProcess();
+        if (!DuplicateHandle(process, GetStdHandle(STD_INPUT_HANDLE), process, &stream->handle, 0, FALSE, DUPLICATE_SAME_ACCESS)) stream->handle = INVALID_HANDLE_VALUE;
+    } else {
+        stream->handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    }
+
+    b32 result = stream->handle != INVALID_HANDLE_VALUE;
+
+    if (result) stream->seekable = GetFileType(stream->handle) == FILE_TYPE_DISK;
+#else
+    // a duplicate, so closing the stream leaves stdin alone
+    stream->file = platform_is_stdin(filename) ? dup(STDIN_FILENO) : open(path, O_RDONLY);
+    b32 result = stream->file >= 0;
+
+    if (result) {
+        struct stat info = {};
+        stream->seekable = fstat(stream->file, &info) == 0 && S_ISREG(info.st_mode);
+
+        posix_fadvise(stream->file, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+#endif
+
+    temp_restore(mark);
+
+    if (!result) {
+        ERRLOG("Could not open file. %.*s", (int)filename.size, filename.data);
+    }
+
+    return result;
+}
+
+// fills the buffer unless the input ends first, eof is set once it did
+b32 platform_stream_read(Input_Stream *stream, u8 *buffer, u64 size, u64 *read_size) {
+    u64 done = 0;
+
+    while (done < size && !stream->eof) {
+#ifdef _WIN32
+        DWORD chunk = (DWORD)MIN(size - done, (u64)GB(1));
+        DWORD count = 0;
+
+        if (!ReadFile(stream->handle, buffer + done, chunk, &count, NULL)) {
+            // the write end of a pipe was closed
+            if (GetLastError() != ERROR_BROKEN_PIPE) return false;
+            count = 0;
+        }
+#else
+        ssize_t count = read(stream->file, buffer + done, size - done);
+
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+#endif
+
+        if (count == 0) stream->eof = true;
+        done += (u64)count;
+    }
+
+    *read_size = done;
+    return true;
+}
+
+// reads at offset without moving the stream, read_size is short at the end of the file
+b32 platform_stream_read_at(Input_Stream *stream, u64 offset, u8 *buffer, u64 size, u64 *read_size) {
+    assert(stream->seekable);
+
+    u64 done = 0;
+
+#ifdef _WIN32
+    // reads with an offset move the file pointer of synchronous handles, so it is put back
+    LARGE_INTEGER position = {};
+    LARGE_INTEGER zero     = {};
+    if (!SetFilePointerEx(stream->handle, zero, &position, FILE_CURRENT)) return false;
+
+    while (done < size) {
+        OVERLAPPED at = {};
+        at.Offset     = (DWORD)(offset + done);
+        at.OffsetHigh = (DWORD)((offset + done) >> 32);
+
+        DWORD chunk = (DWORD)MIN(size - done, (u64)GB(1));
+        DWORD count = 0;
+
+        if (!ReadFile(stream->handle, buffer + done, chunk, &count, &at)) {
+            if (GetLastError() != ERROR_HANDLE_EOF) return false;
+            count = 0;
+        }
+
+        if (count == 0) break;
+        done += count;
+    }
+
+    if (!SetFilePointerEx(stream->handle, position, NULL, FILE_BEGIN)) return false;
+#else
+    while (done < size) {
+        ssize_t count = pread(stream->file, buffer + done, size - done, (off_t)(offset + done));
+
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+
+        if (count == 0) break;
+        done += (u64)count;
+    }
+#endif
+
+    *read_size = done;
+    return true;
+}
+
+void platform_stream_close(Input_Stream *stream) {
+#ifdef _WIN32
+    if (stream->handle && stream->handle != INVALID_HANDLE_VALUE) CloseHandle(stream->handle);
+#else
+    if (stream->file >= 0) close(stream->file);
+#endif
+
+    *stream = {};
+}
+
+/// Chunked reading
+//
+// inputs that can't be mapped are read in chunks into a buffer that doubles when it's full.
+// proc sees the data after every chunk, so the caller can work on it while the rest is
+// still being produced. the buffer moves when it grows, only offsets stay valid.
+
+#define INPUT_STREAM_CHUNK MB(1)
+
+typedef void Input_Chunk_Proc(String data, void *user);
+
+// output is a heap buffer, or empty for empty inputs
+b32 platform_read_stream(String filename, String *output, Input_Chunk_Proc *proc = NULL, void *user = NULL) {
+    Allocator alloc = get_stdlib_allocator();
+    Input_Stream stream = {};
+
+    *output = {};
+
+    if (!platform_stream_open(filename, &stream)) return false;
+
+    u64 capacity = INPUT_STREAM_CHUNK;
+    u64 size     = 0;
+    u8 *buffer   = (u8 *)mem_alloc_uninit(alloc, capacity);
+    b32 result   = buffer != NULL;
+
+    while (result && !stream.eof) {
+        if (size == capacity) {
+            u8 *grown = (u8 *)mem_realloc(alloc, buffer, capacity * 2);
+
+            if (!grown) {
+                result = false;
+                break;
+            }
+
+            buffer    = grown;
+            capacity *= 2;
+        }
+
+        u64 read_size = 0;
+        u64 chunk     = MIN(capacity - size, (u64)INPUT_STREAM_CHUNK);
+
+        if (!platform_stream_read(&stream, buffer + size, chunk, &read_size)) {
+            result = false;
+            break;
+        }
+
+        size += read_size;
+
+        if (proc && read_size) proc({ size, buffer }, user);
+    }
+
+    platform_stream_close(&stream);
+
+    if (!result) {
+        ERRLOG("Could not read file. %.*s", (int)filename.size, filename.data);
+        mem_free(alloc, buffer);
+        return false;
+    }
+
+    if (size == 0) {
+        mem_free(alloc, buffer);
+        return true;
+    }
+
+    *output = { size, buffer };
+    return true;
+}
+
+/// Input files
+//
+// regular files are mapped and scanned in place, everything else
+// (stdin, pipes, special files, failed mappings) is read in chunks into a heap buffer.
+// small files are read with one call too, in directory mode most files are small
+// and mapping them costs more syscalls and page faults than copying them.
+
+#define INPUT_MAP_MIN_SIZE KB(256)
+
+struct Input_File {
+    String data;
+    b32    mapped;
+};
+
+b32 platform_map_file(String filename, Input_File *output) {
+    assert(output != NULL);
+    assert(filename.data != NULL);
+    assert(filename.size > 0);
+
+    char *path = string_to_c_string(filename, get_temporary_allocator());
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size = {};
+    if (GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    if ((u64)size.QuadPart < INPUT_MAP_MIN_SIZE) {
+        u8 *data = size.QuadPart ? (u8 *)mem_alloc_uninit(get_stdlib_allocator(), (u64)size.QuadPart) : NULL;
+        DWORD done = 0;
+
+        b32 result = size.QuadPart == 0 || (ReadFile(file, data, (DWORD)size.QuadPart, &done, NULL) && done == (DWORD)size.QuadPart);
+        CloseHandle(file);
+
+        if (!result) {
+            mem_free(get_stdlib_allocator(), data);
+            return false;
+        }
+
+        output->data   = { (u64)size.QuadPart, data };
+        output->mapped = false;
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+
+    if (mapping == NULL) return false;
+
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+
+    if (view == NULL) return false;
+
+    output->data   = { (u64)size.QuadPart, (u8 *)view };
+#else
+    int file = open(path, O_RDONLY);
+    if (file < 0) return false;
+
+    struct stat info = {};
+    if (fstat(file, &info) != 0 || !S_ISREG(info.st_mode)) {
+        close(file);
+        return false;
+    }
+
+    if ((u64)info.st_size < INPUT_MAP_MIN_SIZE) {
+        u64 size = (u64)info.st_size;
+        u8 *data = size ? (u8 *)mem_alloc_uninit(get_stdlib_allocator(), size) : NULL;
+        u64 done = 0;
+
+        while (done < size) {
+            ssize_t count = read(file, data + done, size - done);
+            if (count <= 0) break;
+            done += (u64)count;
+        }
+
+        close(file);
+
+        if (done < size) {
+            mem_free(get_stdlib_allocator(), data);
+            return false;
+        }
+
+        output->data   = { size, data };
+        output->mapped = false;
+        return true;
+    }
+
+    void *view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+
+    if (view == MAP_FAILED) return false;
+
+    madvise(view, (size_t)info.st_size, MADV_SEQUENTIAL);
+    madvise(view, (size_t)info.st_size, MADV_WILLNEED);
+
+    output->data   = { (u64)info.st_size, (u8 *)view };
+#endif
+
+    output->mapped = true;
+    return true;
+}
+
+b32 platform_open_input(String filename, Input_File *output) {
+    *output = {};
+
+    // only the c string path lands in temp memory
+    u64 mark = temp_mark();
+    b32 result = (!platform_is_stdin(filename) && platform_map_file(filename, output))
+              || platform_read_stream(filename, &output->data);
+    temp_restore(mark);
+
+    return result;
+}
+
+void platform_close_input(Input_File *file) {
+    if (file->data.data == NULL) return;
+
+    if (file->mapped) {
+#ifdef _WIN32
+        UnmapViewOfFile(file->data.data);
+#else
+        munmap(file->data.data, file->data.size);
+#endif
+    } else {
+        mem_free(get_stdlib_allocator(), file->data.data);
+    }
+
+    *file = {};
+}
+
+/// Standard output
+
+// writes all parts in order, retries on partial writes
+b32 platform_write_stdout(String *parts, u32 count) {
+#ifdef _WIN32
+    HANDLE handle = GetStdHandle(STD_OUTPUT_HANDLE);
+
+    for (u32 i = 0; i < count; i++) {
+        u8 *data = parts[i].data;
+        u64 size = parts[i].size;
+
+        while (size > 0) {
+            DWORD chunk   = (DWORD)MIN(size, (u64)GB(1));
+            DWORD written = 0;
+
+            if (!WriteFile(handle, data, chunk, &written, NULL)) return false;
+
+            data += written;
+            size -= written;
+        }
+    }
+#else
+    struct iovec vectors[8];
+    assert(count <= 8);
+
+    for (u32 i = 0; i < count; i++) {
+        vectors[i].iov_base = parts[i].data;
+        vectors[i].iov_len  = parts[i].size;
+    }
+
+    struct iovec *vector = vectors;
+
+    while (count > 0) {
+        ssize_t written = writev(STDOUT_FILENO, vector, (int)count);
+        if (written < 0) return false;
+
+        while (count > 0 && (u64)written >= vector->iov_len) {
+            written -= vector->iov_len;
+            vector++;
+            count--;
+        }
+
+        if (count > 0) {
+            vector->iov_base = (u8 *)vector->iov_base + written;
+            vector->iov_len -= written;
+        }
+    }
+#endif
+
+    return true;
+}
+
+/// Time
+
+// monotonic clock, only differences between two calls mean anything
+u64 platform_time_ns(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency = {};
+    LARGE_INTEGER counter   = {};
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    u64 seconds = (u64)(counter.QuadPart / frequency.QuadPart);
+    u64 rest    = (u64)(counter.QuadPart % frequency.QuadPart);
+    return seconds * 1000000000ull + rest * 1000000000ull / (u64)frequency.QuadPart;
+#else
+    struct timespec time = {};
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (u64)time.tv_sec * 1000000000ull + (u64)time.tv_nsec;
+#endif
+}
+
+/// Threads and atomics
+
+typedef void Thread_Proc(void *data);
+
+struct Thread {
+    Thread_Proc *proc;
+    void        *data;
+
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+};
+
+#ifdef _WIN32
+static DWORD WINAPI thread_entry(LPVOID parameter) {
+    Thread *thread = (Thread *)parameter;
+    thread->proc(thread->data);
+    return 0;
+}
+#else
+static void *thread_entry(void *parameter) {
+    Thread *thread = (Thread *)parameter;
+    thread->proc(thread->data);
+    return NULL;
+}
+#endif
+
+// thread has to stay alive until it's joined
+b32 platform_thread_start(Thread *thread, Thread_Proc *proc, void *data) {
+    thread->proc = proc;
+    thread->data = data;
+
+#ifdef _WIN32
+    thread->handle = CreateThread(NULL, 0, thread_entry, thread, 0, NULL);
+    return thread->handle != NULL;
+#else
+    return pthread_create(&thread->handle, NULL, thread_entry, thread) == 0;
+#endif
+}
+
+void platform_thread_join(Thread *thread) {
+#ifdef _WIN32
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join(thread->handle, NULL);
+#endif
+}
+
+void platform_yield(void) {
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+u64 platform_atomic_add(u64 *value, u64 amount) {
+    return __atomic_fetch_add(value, amount, __ATOMIC_RELAXED);
+}
+
+// stores with release and loads with acquire, so everything written before
+// the store is visible to a thread that sees the new value
+void platform_atomic_store(u32 *value, u32 new_value) {
+    __atomic_store_n(value, new_value, __ATOMIC_RELEASE);
+}
+
+u32 platform_atomic_load(u32 *value) {
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+
+u32 platform_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info = {};
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (u32)info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (u32)count : 1;
+#endif
+}
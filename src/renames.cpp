@@ -0,0 +1,373 @@
+/// Rename and copy detection
+//
+// every candidate file gets a minhash sketch of its set of line hashes: slot i keeps the
+// smallest value of the i-th mix over all lines, so the share of equal slots between two
+// sketches estimates how many distinct lines the files share (jaccard similarity).
+// sketches are split into bands, files with an equal band land in the same bucket, and
+// only files sharing a bucket are compared. buckets are found by sorting, so the whole
+// search is O(n log n) in the number of files instead of diffing all pairs. a pair is
+// only taken when its exact similarity holds up too, and that's the one printed.
+
+#define SKETCH_SIZE  64
+#define SKETCH_BANDS 32
+#define SKETCH_ROWS  (SKETCH_SIZE / SKETCH_BANDS)
+
+// files sharing a bucket past this are skipped, so common lines can't make it quadratic
+#define RENAME_MAX_BUCKET 64
+
+#define RENAME_DEFAULT_SIMILARITY 50
+
+struct Sketch {
+    u64 mins[SKETCH_SIZE];
+    b32 valid; // empty and unreadable files have no sketch and never match
+};
+
+static inline u64 sketch_mix(u64 value, u64 slot) {
+    // splitmix64 finalizer, a different offset per slot
+    value += (slot + 1) * 0x9e3779b97f4a7c15ull;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+void sketch_lines(List<Hash128> hashes, Sketch *sketch) {
+    *sketch = {};
+    if (hashes.count == 0) return;
+
+    for (u64 slot = 0; slot < SKETCH_SIZE; slot++) sketch->mins[slot] = ~0ull;
+
+    for (u64 line = 0; line < hashes.count; line++) {
+        u64 value = hashes[line].low;
+
+        for (u64 slot = 0; slot < SKETCH_SIZE; slot++) {
+            u64 mixed = sketch_mix(value, slot);
+            if (mixed < sketch->mins[slot]) sketch->mins[slot] = mixed;
+        }
+    }
+
+    sketch->valid = true;
+}
+
+// estimated similarity in percent
+u32 sketch_similarity(Sketch *a, Sketch *b) {
+    if (!a->valid || !b->valid) return 0;
+
+    u32 equal = 0;
+
+    for (u64 slot = 0; slot < SKETCH_SIZE; slot++) {
+        equal += a->mins[slot] == b->mins[slot];
+    }
+
+    return equal * 100 / SKETCH_SIZE;
+}
+
+struct Rename_File {
+    String root;
+    String path;
+    Sketch sketch;
+
+    u64 pair;   // index in the pair list
+    b32 source; // origin side, otherwise an added file
+};
+
+struct Rename_Bucket_Entry {
+    u64 key;
+    u32 band;
+    u32 file;
+};
+
+struct Rename_Candidate {
+    u32 similarity;
+    u32 target;
+    u32 source;
+};
+
+static char *rename_file_path(Rename_File *file) {
+    return string_to_c_string(string_concat(file->root, string_concat(STR("/"), file->path, get_temporary_allocator()), get_temporary_allocator()), get_temporary_allocator());
+}
+
+static void rename_sketch_proc(void *data, u64 index) {
+    Rename_File *file = (Rename_File *)data + index;
+
+    char *path = rename_file_path(file);
+
+    Input_File input = {};
+    if (!platform_open_input(STR(path), &input)) return;
+
+    Hashed_Lines scan = scan_and_hash_lines(input.data, 1);
+    sketch_lines(scan.hashes, &file->sketch);
+
+    if (scan.lines.data)  list_delete(&scan.lines);
+    if (scan.hashes.data) list_delete(&scan.hashes);
+    platform_close_input(&input);
+}
+
+static int rename_compare_u64(const void *a, const void *b) {
+    u64 left  = *(u64 *)a;
+    u64 right = *(u64 *)b;
+    return left < right ? -1 : left > right;
+}
+
+// the distinct line hashes of the file, sorted
+static List<u64> rename_line_set(Input_File *input) {
+    Hashed_Lines scan = scan_and_hash_lines(input->data, 1);
+    List<u64> set = {};
+
+    list_create(&set, scan.hashes.count + 1);
+
+    for (u64 i = 0; i < scan.hashes.count; i++) set.data[i] = scan.hashes[i].low;
+    set.count = scan.hashes.count;
+
+    if (set.count > 1) qsort(set.data, set.count, sizeof(u64), rename_compare_u64);
+
+    u64 kept = 0;
+
+    for (u64 i = 0; i < set.count; i++) {
+        if (kept == 0 || set.data[kept - 1] != set.data[i]) set.data[kept++] = set.data[i];
+    }
+
+    set.count = kept;
+
+    if (scan.lines.data)  list_delete(&scan.lines);
+    if (scan.hashes.data) list_delete(&scan.hashes);
+
+    return set;
+}
+
+// the share of distinct lines the files have in common, in percent. the sketches only
+// estimate it to pick candidates, this is what a reported pair gets checked and printed with.
+// rounded down, and files that differ at all stay below 100 even with the same lines.
+static u32 rename_exact_similarity(Rename_File *target, Rename_File *source) {
+    u64 mark = temp_mark();
+
+    Input_File target_input = {};
+    Input_File source_input = {};
+
+    b32 opened = platform_open_input(STR(rename_file_path(target)), &target_input)
+              && platform_open_input(STR(rename_file_path(source)), &source_input);
+
+    temp_restore(mark);
+
+    u32 similarity = 0;
+
+    if (opened) {
+        List<u64> target_set = rename_line_set(&target_input);
+        List<u64> source_set = rename_line_set(&source_input);
+
+        u64 common = 0;
+
+        for (u64 i = 0, j = 0; i < target_set.count && j < source_set.count;) {
+            if (target_set.data[i] == source_set.data[j]) {
+                common++;
+                i++;
+                j++;
+            } else if (target_set.data[i] < source_set.data[j]) {
+                i++;
+            } else {
+                j++;
+            }
+        }
+
+        u64 total = target_set.count + source_set.count - common;
+        if (total > 0) similarity = (u32)(common * 100 / total);
+
+        b32 identical = target_input.data.size == source_input.data.size
+                     && mem_compare(target_input.data.data, source_input.data.data, target_input.data.size) == 0;
+
+        if (similarity == 100 && !identical) similarity = 99;
+
+        list_delete(&target_set);
+        list_delete(&source_set);
+    }
+
+    platform_close_input(&target_input);
+    platform_close_input(&source_input);
+
+    return similarity;
+}
+
+static int rename_compare_entries(const void *a, const void *b) {
+    Rename_Bucket_Entry *left  = (Rename_Bucket_Entry *)a;
+    Rename_Bucket_Entry *right = (Rename_Bucket_Entry *)b;
+
+    if (left->band != right->band) return left->band < right->band ? -1 : 1;
+    if (left->key  != right->key)  return left->key  < right->key  ? -1 : 1;
+    if (left->file != right->file) return left->file < right->file ? -1 : 1;
+    return 0;
+}
+
+// best first, ties in file order so the result doesn't depend on the sort
+static int rename_compare_candidates(const void *a, const void *b) {
+    Rename_Candidate *left  = (Rename_Candidate *)a;
+    Rename_Candidate *right = (Rename_Candidate *)b;
+
+    if (left->similarity != right->similarity) return left->similarity > right->similarity ? -1 : 1;
+    if (left->target != right->target) return left->target < right->target ? -1 : 1;
+    if (left->source != right->source) return left->source < right->source ? -1 : 1;
+    return 0;
+}
+
+static List<Rename_Candidate> rename_find_candidates(Rename_File *files, u64 count, u32 min_similarity) {
+    List<Rename_Bucket_Entry> entries = {};
+    List<Rename_Candidate>    candidates = {};
+
+    list_create(&entries, count * SKETCH_BANDS + 1);
+
+    for (u64 i = 0; i < count; i++) {
+        if (!files[i].sketch.valid) continue;
+
+        for (u32 band = 0; band < SKETCH_BANDS; band++) {
+            u64 key = 0;
+
+            for (u32 row = 0; row < SKETCH_ROWS; row++) {
+                key = sketch_mix(key ^ files[i].sketch.mins[band * SKETCH_ROWS + row], row);
+            }
+
+            Rename_Bucket_Entry entry = { key, band, (u32)i };
+            list_add(&entries, entry);
+        }
+    }
+
+    if (entries.count > 1) qsort(entries.data, entries.count, sizeof(Rename_Bucket_Entry), rename_compare_entries);
+
+    for (u64 start = 0, stop = 0; start < entries.count; start = stop) {
+        stop = start + 1;
+
+        while (stop < entries.count && entries[stop].band == entries[start].band && entries[stop].key == entries[start].key) {
+            stop++;
+        }
+
+        u64 size = stop - start;
+        if (size > RENAME_MAX_BUCKET) size = RENAME_MAX_BUCKET;
+
+        for (u64 a = start; a < start + size; a++) {
+            Rename_File *target = files + entries[a].file;
+            if (target->source) continue;
+
+            for (u64 b = start; b < start + size; b++) {
+                Rename_File *source = files + entries[b].file;
+                if (!source->source) continue;
+
+                u32 similarity = sketch_similarity(&target->sketch, &source->sketch);
+                if (similarity < min_similarity) continue;
+
+                Rename_Candidate candidate = { similarity, entries[a].file, entries[b].file };
+                list_add(&candidates, candidate);
+            }
+        }
+    }
+
+    list_delete(&entries);
+
+    if (candidates.count > 1) qsort(candidates.data, candidates.count, sizeof(Rename_Candidate), rename_compare_candidates);
+    return candidates;
+}
+
+// pairs added files with the deleted file they were most likely renamed from (rename_similarity)
+// and, when copy_similarity isn't 0, the remaining added files with any origin file they were
+// copied from. a renamed source drops out of the pair list, copies keep theirs. 0 turns a pass off.
+void tree_detect_renames(List<Tree_Pair> *pairs, String origin_root, String compare_root, u32 rename_similarity, u32 copy_similarity, u32 threads) {
+    Allocator alloc = get_stdlib_allocator();
+
+    if (rename_similarity == 0 && copy_similarity == 0) return;
+
+    List<Rename_File> files = {};
+    list_create(&files, pairs->count + 1);
+
+    for (u64 i = 0; i < pairs->count; i++) {
+        Tree_Pair pair = pairs->data[i];
+
+        // copies can come from any origin file, renames only from deleted ones
+        b32 source = pair.in_origin && (copy_similarity != 0 || !pair.in_compare);
+        b32 target = pair.in_compare && !pair.in_origin;
+
+        if (!source && !target) continue;
+
+        Rename_File file = {};
+        file.root   = source ? origin_root : compare_root;
+        file.path   = pair.path;
+        file.pair   = i;
+        file.source = source;
+
+        list_add(&files, file);
+    }
+
+    u64 targets = 0;
+    u64 sources = 0;
+
+    for (u64 i = 0; i < files.count; i++) {
+        if (files[i].source) sources++; else targets++;
+    }
+
+    if (targets == 0 || sources == 0) {
+        list_delete(&files);
+        return;
+    }
+
+    tree_run_tasks(rename_sketch_proc, files.data, files.count, threads);
+
+    u32 min_similarity = rename_similarity;
+    if (copy_similarity != 0 && (min_similarity == 0 || copy_similarity < min_similarity)) min_similarity = copy_similarity;
+
+    List<Rename_Candidate> candidates = rename_find_candidates(files.data, files.count, min_similarity);
+
+    // matched[file] is 1 for targets that got a source and renamed sources
+    u8 *matched = (u8 *)mem_alloc(alloc, files.count);
+    b8 *removed = (b8 *)mem_alloc(alloc, pairs->count);
+
+    for (u32 pass = 0; pass < 2; pass++) {
+        b32 copies     = pass == 1;
+        u32 similarity = copies ? copy_similarity : rename_similarity;
+
+        if (similarity == 0) continue;
+
+        for (u64 i = 0; i < candidates.count; i++) {
+            Rename_Candidate candidate = candidates[i];
+            if (candidate.similarity < similarity) break;
+
+            Rename_File *target = files.data + candidate.target;
+            Rename_File *source = files.data + candidate.source;
+
+            if (matched[candidate.target]) continue;
+
+            Tree_Pair *source_pair = pairs->data + source->pair;
+
+            if (!copies && (source_pair->in_compare || matched[candidate.source])) continue;
+
+            // the estimate picked the pair, the exact similarity has to hold it
+            u32 exact = rename_exact_similarity(target, source);
+            if (exact < similarity) continue;
+
+            if (!copies) {
+                matched[candidate.source] = true;
+                removed[source->pair]     = true;
+            }
+
+            matched[candidate.target] = true;
+
+            Tree_Pair *target_pair  = pairs->data + target->pair;
+            target_pair->in_origin  = true;
+            target_pair->source     = string_copy(source->path, alloc);
+            target_pair->copy       = copies;
+            target_pair->similarity = exact;
+        }
+    }
+
+    u64 kept = 0;
+
+    for (u64 i = 0; i < pairs->count; i++) {
+        if (removed[i]) {
+            mem_free(alloc, pairs->data[i].path.data);
+            continue;
+        }
+
+        pairs->data[kept++] = pairs->data[i];
+    }
+
+    pairs->count = kept;
+
+    mem_free(alloc, matched);
+    mem_free(alloc, removed);
+    if (candidates.data) list_delete(&candidates);
+    list_delete(&files);
+}
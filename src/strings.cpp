@@ -9,7 +9,7 @@
 #define SWAP_SLASH (u8)'\\'
 #endif
 
-#define tformat(cstr, ...) string_format(get_temporary_allocator(), STR(cstr), __VA_ARGS__)
+#define tformat(cstr, ...) string_format(get_temporary_allocator(), STR(cstr), ##__VA_ARGS__)
 #define tcstr(str) string_to_c_string(str, get_temporary_allocator())
 #define tprint(cstr, ...) printf("%s", tcstr(tformat(cstr, __VA_ARGS__)))
 
@@ -39,7 +39,7 @@ String string_copy(String a, Allocator alloc);
 char *string_to_c_string(String a, Allocator alloc) {
     assert(a.data != NULL);
 
-    u8* data = (u8*)mem_alloc(alloc, a.size + 1);
+    u8* data = (u8*)mem_alloc_uninit(alloc, a.size + 1);
 
     if (data == NULL) {
         ERRLOG("string conversion failed, buy more ram, or provide normal allocator...");
@@ -47,6 +47,7 @@ char *string_to_c_string(String a, Allocator alloc) {
     }
 
     mem_copy(data, a.data, a.size);
+    data[a.size] = '\0';
     return (char*)data;
 }
 
@@ -79,7 +80,9 @@ s32 string_compare(String a, String b) {
     if (b.size == 0) return 1;
 
 
-    s32 result = mem_compare(a.data, b.data, a.size);
+    // only the shared part is compared bytewise, the shorter string sorts first
+    u64 size = a.size < b.size ? a.size : b.size;
+    s32 result = mem_compare(a.data, b.data, size);
 
     if (result == 0) {
         if (a.size > b.size) return 1;
@@ -141,7 +144,7 @@ List<String> string_split(String input, String pattern) {
             continue;
         }
 
-        u8* buffer = (u8*)mem_alloc(talloc, size);
+        u8* buffer = (u8*)mem_alloc_uninit(talloc, size);
         mem_copy(buffer, input.data + start, size);
         String output = { .size = size, .data = buffer };
         list_add(&splits, output);
@@ -158,7 +161,7 @@ List<String> string_split(String input, String pattern) {
             return splits;
         }
 
-        u8* buffer = (u8*)mem_alloc(talloc, size);
+        u8* buffer = (u8*)mem_alloc_uninit(talloc, size);
         mem_copy(buffer, input.data + start, size);
         String output = { .size = size, .data = buffer };
         list_add(&splits, output);
@@ -172,7 +175,7 @@ String string_copy(String a, Allocator alloc) {
         return {};
     }
 
-    u8* data = (u8*)mem_alloc(alloc, a.size);
+    u8* data = (u8*)mem_alloc_uninit(alloc, a.size);
 
     if (data == NULL) {
         ERRLOG("string copy failed, buy more ram, or provide normal allocator...");
@@ -188,7 +191,7 @@ String string_concat(String a, String b, Allocator alloc) {
         return {};
     }
 
-    u8* data = (u8*)mem_alloc(alloc, a.size + b.size);
+    u8* data = (u8*)mem_alloc_uninit(alloc, a.size + b.size);
 
     if (a.size > 0) {
         assert(a.data != NULL);
@@ -209,7 +212,7 @@ String string_substring(String input, u64 start, u64 size, Allocator alloc) {
         ERRLOG("start position with size overlapping the input string.");
         return {};
     }
-    u8* data = (u8*)mem_alloc(alloc, size);
+    u8* data = (u8*)mem_alloc_uninit(alloc, size);
     mem_copy(data, input.data + start, size);
 
     return {.size = size, .data = (u8*) data };
@@ -233,111 +236,140 @@ s64 string_last_index_of(String input, u8 value) {
     return index;
 }
 
-static String format_u64(u64 value) {
-    if (value == 0) {
-        return STR("0");
-    }
- 
-    Allocator talloc = get_temporary_allocator();
-    String     output = {};
+/// String builder
+//
+// capacity doubles when it runs out, so appending n bytes costs O(n) in total.
 
-    while (value) {
-        u8 digit = '0' + (value % 10);
-        output = string_concat(output, { 1, &digit }, talloc);
-        value /= 10;
-    }
+struct String_Builder {
+    u8       *data;
+    u64       size;
+    u64       capacity;
+    Allocator alloc;
+};
+
+void builder_create(String_Builder *builder, Allocator alloc, u64 capacity = 64) {
+    *builder = {};
+    builder->alloc    = alloc;
+    builder->data     = (u8*)mem_alloc_uninit(alloc, capacity);
+    builder->capacity = builder->data ? capacity : 0;
+}
 
-    for (u64 l = 0, r = output.size - 1; l < r; l++, r--) {
-        u8 t           = output[l];
-        output.data[l] = output[r];
-        output.data[r] = t;
+b32 builder_reserve(String_Builder *builder, u64 size) {
+    if (builder->size + size <= builder->capacity) return true;
+
+    u64 capacity = builder->capacity ? builder->capacity : 64;
+    while (capacity < builder->size + size) capacity *= 2;
+
+    u8* data = (u8*)mem_alloc_uninit(builder->alloc, capacity);
+
+    if (data == NULL) {
+        ERRLOG("builder growth failed, buy more ram, or provide normal allocator...");
+        return false;
     }
 
-    return output;
+    mem_copy(data, builder->data, builder->size);
+    if (builder->data) mem_free(builder->alloc, builder->data);
+
+    builder->data     = data;
+    builder->capacity = capacity;
+    return true;
 }
 
-static String format_s64(s64 value) {
-    if (value == 0) {
-        return STR("0");
-    }
- 
-    Allocator talloc = get_temporary_allocator();
-    String     output = {};
+void builder_append(String_Builder *builder, String a) {
+    if (a.size == 0 || !builder_reserve(builder, a.size)) return;
 
-    b32 negative = false;
+    mem_copy(builder->data + builder->size, a.data, a.size);
+    builder->size += a.size;
+}
 
-    if (value < 0) {
-        value    = -value;
-        negative = true;
-    }
+void builder_append(String_Builder *builder, u8 c) {
+    if (!builder_reserve(builder, 1)) return;
+    builder->data[builder->size++] = c;
+}
 
-    while (value) {
-        u8 digit = '0' + (value % 10);
-        output = string_concat(output, { 1, &digit }, talloc);
+// digits are written in place, from the back
+void builder_append_u64(String_Builder *builder, u64 value) {
+    u64 digits = 1;
+    for (u64 rest = value / 10; rest; rest /= 10) digits++;
+
+    if (!builder_reserve(builder, digits)) return;
+
+    u8 *end = builder->data + builder->size + digits;
+
+    do {
+        *--end = (u8)('0' + value % 10);
         value /= 10;
-    }
+    } while (value);
 
-    if (negative) {
-        u8 sign = '-';
-        output = string_concat(output, { 1, &sign }, talloc);
-    }
+    builder->size += digits;
+}
 
-    for (u64 l = 0, r = output.size - 1; l < r; l++, r--) {
-        u8 t           = output[l];
-        output.data[l] = output[r];
-        output.data[r] = t;
+void builder_append_s64(String_Builder *builder, s64 value) {
+    if (value < 0) {
+        builder_append(builder, (u8)'-');
+        builder_append_u64(builder, (u64)0 - (u64)value);
+    } else {
+        builder_append_u64(builder, (u64)value);
     }
-
-    return output;
 }
 
-String string_format(Allocator alloc, String buffer...) {
-    va_list args;
-    va_start(args, buffer);
-    
-    Allocator talloc = get_temporary_allocator();
+String builder_to_string(String_Builder *builder) {
+    return { .size = builder->size, .data = builder->data };
+}
 
-    String o = {};
-    
+void string_format_into(String_Builder *builder, String buffer, va_list args) {
     for (u64 i = 0; i < buffer.size; i++) {
-        if (buffer[i] != '%') {
-            o = string_concat(o, { 1, buffer.data + i }, talloc);
-            continue;
+        // copy everything up to the next % in one go
+        u64 run = i;
+        while (run < buffer.size && buffer[run] != '%') run++;
+
+        if (run > i) {
+            builder_append(builder, { run - i, buffer.data + i });
+            i = run;
+            if (i == buffer.size) break;
         }
 
         switch (buffer[++i]) {
             case '%':
             {
-                o = string_concat(o, { 1, buffer.data + i }, talloc);
+                builder_append(builder, (u8)'%');
             } break;
             case 'c':
             {
                 u32 b = va_arg(args, u32);
-                o = string_concat(o, {1, (u8*)&b }, talloc);
+                builder_append(builder, (u8)b);
             } break;
 
             case 'u':
             {
-                o = string_concat(o, format_u64(va_arg(args, u64)), talloc);
+                builder_append_u64(builder, va_arg(args, u64));
             } break;
 
             case 'd': 
             {
-                o = string_concat(o, format_s64(va_arg(args, s64)), talloc);
+                builder_append_s64(builder, va_arg(args, s64));
             } break;
 
             case 's':
             {
-                o = string_concat(o, va_arg(args, String), talloc);
+                builder_append(builder, va_arg(args, String));
             } break;
             default: break;
         }
     }
-    // va_arg(args, );
-    // va_arg(args, long long);
+}
+
+String string_format(Allocator alloc, String buffer...) {
+    va_list args;
+    va_start(args, buffer);
+
+    String_Builder builder = {};
+    builder_create(&builder, alloc, buffer.size + 16);
+
+    string_format_into(&builder, buffer, args);
 
     va_end(args);
-    return string_copy(o, alloc);
+    return builder_to_string(&builder);
 }
 
 void string_tests(void) {
@@ -427,6 +459,10 @@ void string_tests(void) {
 
     list_delete(&splits);
 
+    assert(string_compare(STR("ab"), STR("abc")) < 0);
+    assert(string_compare(STR("abc"), STR("ab")) > 0);
+    assert(string_compare(STR("abd"), STR("abc")) > 0);
+
     assert(!string_compare(string_substring(STR("HelloWorld!"), 5, 6, alloc), STR("World!")));
     assert(!string_compare(string_substring(STR("HelloWorld!"), 0, 11, alloc), STR("HelloWorld!")));
     assert(!string_compare(string_substring(STR("HelloWorld!"), 10, 1, alloc), STR("!")));
@@ -437,6 +473,18 @@ void string_tests(void) {
     assert(!string_compare(string_swap(STR("/path/from/unix/systems/"), (u8)'/', (u8) '\\', alloc), STR("\\path\\from\\unix\\systems\\"))); 
 
     assert(!string_compare(string_format(alloc, STR("/path/%s/unix/a %d %u %%"), STR("test"), (s64)-100, (u64)404), STR("/path/test/unix/a -100 404 %"))); 
+    assert(!string_compare(string_format(alloc, STR("%u|%d|%d"), (u64)0, (s64)0, (s64)-9223372036854775807LL - 1), STR("0|0|-9223372036854775808")));
+
+    String_Builder builder = {};
+    builder_create(&builder, alloc, 1);
+
+    for (u64 i = 0; i < 100; i++) {
+        builder_append_u64(&builder, i % 10);
+    }
+
+    assert(builder.size == 100);
+    assert(builder.capacity >= 100);
+    assert(!string_compare(string_substring(builder_to_string(&builder), 90, 10, alloc), STR("0123456789")));
 
     temp_reset();
 #endif
@@ -0,0 +1,153 @@
+/// Directory trees
+//
+// both trees are walked into sorted lists of relative paths ('/' separated on every
+// platform), which are merged into pairs. a pair that only exists on one side is a
+// deleted or an added file. rename and copy detection (renames.cpp) turns added files
+// into pairs with a source, the origin file they were moved or copied from.
+
+struct Tree_Pair {
+    String path; // relative to both roots
+    b32    in_origin;
+    b32    in_compare;
+
+    String source;     // origin path of a rename or copy, path is the compare side then
+    b32    copy;
+    u32    similarity; // percent
+};
+
+static void tree_walk(String root, String relative, List<String> *files) {
+    List<Directory_Entry> entries = {};
+
+    String directory = root;
+    if (relative.size > 0) directory = string_concat(root, string_concat(STR("/"), relative, get_temporary_allocator()), get_temporary_allocator());
+
+    if (!platform_list_directory(directory, &entries, get_stdlib_allocator())) return;
+
+    for (u64 i = 0; i < entries.count; i++) {
+        Directory_Entry entry = entries[i];
+        String path = entry.name;
+
+        if (relative.size > 0) {
+            String prefix = string_concat(relative, STR("/"), get_temporary_allocator());
+            path = string_concat(prefix, entry.name, get_stdlib_allocator());
+            mem_free(get_stdlib_allocator(), entry.name.data);
+        }
+
+        if (entry.directory) {
+            tree_walk(root, path, files);
+            mem_free(get_stdlib_allocator(), path.data);
+        } else {
+            list_add(files, path);
+        }
+    }
+
+    if (entries.data) list_delete(&entries);
+}
+
+static int tree_compare_paths(const void *a, const void *b) {
+    return string_compare(*(String *)a, *(String *)b);
+}
+
+// every regular file under root, sorted
+List<String> tree_list_files(String root) {
+    List<String> files = {};
+
+    u64 mark = temp_mark();
+    tree_walk(root, {}, &files);
+    temp_restore(mark);
+
+    if (files.count > 1) qsort(files.data, files.count, sizeof(String), tree_compare_paths);
+    return files;
+}
+
+// merges the sorted file lists, the pairs take over the path strings
+List<Tree_Pair> tree_pair_files(List<String> origin, List<String> compare) {
+    List<Tree_Pair> pairs = {};
+    list_create(&pairs, origin.count + compare.count + 1);
+
+    u64 a = 0;
+    u64 b = 0;
+
+    while (a < origin.count || b < compare.count) {
+        s32 order = 0;
+
+        if (a == origin.count) {
+            order = 1;
+        } else if (b == compare.count) {
+            order = -1;
+        } else {
+            order = string_compare(origin[a], compare[b]);
+        }
+
+        Tree_Pair pair = {};
+
+        if (order == 0) {
+            pair = { origin[a++], true, true };
+            mem_free(get_stdlib_allocator(), compare[b++].data);
+        } else if (order < 0) {
+            pair = { origin[a++], true, false };
+        } else {
+            pair = { compare[b++], false, true };
+        }
+
+        list_add(&pairs, pair);
+    }
+
+    return pairs;
+}
+
+void tree_delete_pairs(List<Tree_Pair> *pairs) {
+    for (u64 i = 0; i < pairs->count; i++) {
+        mem_free(get_stdlib_allocator(), pairs->data[i].path.data);
+        if (pairs->data[i].source.data) mem_free(get_stdlib_allocator(), pairs->data[i].source.data);
+    }
+
+    list_delete(pairs);
+}
+
+/// Parallel tasks
+//
+// runs proc for every index on the calling thread and threads - 1 workers,
+// temp memory is reset after every task.
+
+typedef void Tree_Task_Proc(void *data, u64 index);
+
+struct Tree_Tasks {
+    Tree_Task_Proc *proc;
+    void           *data;
+    u64             count;
+    u64             next;
+};
+
+static void tree_tasks_run(Tree_Tasks *tasks) {
+    for (u64 index; (index = platform_atomic_add(&tasks->next, 1)) < tasks->count;) {
+        tasks->proc(tasks->data, index);
+        temp_reset();
+    }
+}
+
+static void tree_tasks_worker(void *data) {
+    tree_tasks_run((Tree_Tasks *)data);
+    temp_release();
+}
+
+void tree_run_tasks(Tree_Task_Proc *proc, void *data, u64 count, u32 threads) {
+    Tree_Tasks tasks = { proc, data, count, 0 };
+
+    if (threads > count) threads = (u32)count;
+    if (threads < 1) threads = 1;
+
+    Thread *workers = (Thread *)mem_alloc(get_stdlib_allocator(), threads * sizeof(Thread));
+
+    for (u32 i = 1; i < threads; i++) {
+        if (!platform_thread_start(&workers[i], tree_tasks_worker, &tasks)) workers[i].proc = NULL;
+    }
+
+    tree_tasks_run(&tasks);
+
+    for (u32 i = 1; i < threads; i++) {
+        if (workers[i].proc) platform_thread_join(&workers[i]);
+    }
+
+    mem_free(get_stdlib_allocator(), workers);
+}